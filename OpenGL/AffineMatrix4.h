@@ -0,0 +1,206 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include "Vector.h"
+#include "Matrix3.h"
+#include "Matrix4.h"
+
+/*
+	Matrix4 whose last column is (0, 0, 0, 1), which is every model and view matrix made of
+	rotations, scales and translations. Only the three other columns are stored, each one contiguous
+
+				c0	c1	c2
+		r0	|	0	4	8	|	0
+		r1	|	1	5	9	|	0
+		r2	|	2	6	10	|	0
+		r3	|	3	7	11	|	1
+
+	Rows 0 to 2 are the linear part and row 3 is the translation, vectors multiply as rows like with Matrix4.
+	Transforming a vector is 3 four wide dot products instead of 4, composing two of them 36 multiplies
+	instead of 64, and the inverse only has to invert the 3 x 3 part.
+*/
+template <class Type>
+class AffineMatrix4
+{
+private:
+	std::array<Type, 12> elements;
+
+public:
+	constexpr AffineMatrix4()
+		: elements({ 0 })
+	{}
+
+	// Elements given row by row like the Matrix4 constructor
+	constexpr AffineMatrix4(Type _00, Type _01, Type _02,
+		Type _10, Type _11, Type _12,
+		Type _20, Type _21, Type _22,
+		Type _30, Type _31, Type _32)
+		: elements({ _00, _10, _20, _30, _01, _11, _21, _31, _02, _12, _22, _32 })
+	{}
+
+	constexpr AffineMatrix4(const Matrix3<Type>& linear, const vec3<Type>& translation)
+		: AffineMatrix4(linear[0], linear[1], linear[2],
+			linear[3], linear[4], linear[5],
+			linear[6], linear[7], linear[8],
+			translation.x, translation.y, translation.z)
+	{}
+
+	// Drops the last column, only exact when it is (0, 0, 0, 1)
+	constexpr explicit AffineMatrix4(const Matrix4<Type>& matrix)
+		: AffineMatrix4(matrix[0], matrix[1], matrix[2],
+			matrix[4], matrix[5], matrix[6],
+			matrix[8], matrix[9], matrix[10],
+			matrix[12], matrix[13], matrix[14])
+	{}
+
+	// Index into the column layout above
+	constexpr Type operator [] (const int index) const
+	{
+		return elements[index];
+	}
+
+	constexpr Type& operator [] (const int index)
+	{
+		return elements[index];
+	}
+
+	constexpr Type Get(const int row, const int col) const
+	{
+		return elements[col * 4 + row];
+	}
+
+	constexpr Matrix3<Type> GetLinear() const
+	{
+		return Matrix3<Type>(elements[0], elements[4], elements[8],
+			elements[1], elements[5], elements[9],
+			elements[2], elements[6], elements[10]);
+	}
+
+	constexpr vec3<Type> GetTranslation() const
+	{
+		return vec3<Type>(elements[3], elements[7], elements[11]);
+	}
+
+	constexpr vec4<Type> GetCol(const int index) const
+	{
+		return vec4<Type>(elements[index * 4 + 0], elements[index * 4 + 1], elements[index * 4 + 2], elements[index * 4 + 3]);
+	}
+
+	constexpr void SetCol(const int index, const vec4<Type>& column)
+	{
+		elements[index * 4 + 0] = column.x;
+		elements[index * 4 + 1] = column.y;
+		elements[index * 4 + 2] = column.z;
+		elements[index * 4 + 3] = column.w;
+	}
+
+	constexpr Matrix4<Type> ToMatrix4() const
+	{
+		return Matrix4<Type>(elements[0], elements[4], elements[8], 0,
+			elements[1], elements[5], elements[9], 0,
+			elements[2], elements[6], elements[10], 0,
+			elements[3], elements[7], elements[11], 1);
+	}
+
+	// Same as Matrix4 * vec4, w passes through unchanged
+	constexpr vec4<Type> operator * (const vec4<Type>& vector) const
+	{
+		return vec4<Type>(vector.Dot(GetCol(0)), vector.Dot(GetCol(1)), vector.Dot(GetCol(2)), vector.w);
+	}
+
+	// Point with w = 1
+	constexpr vec3<Type> TransformPoint(const vec3<Type>& point) const
+	{
+		return vec3<Type>(point.x * elements[0] + point.y * elements[1] + point.z * elements[2] + elements[3],
+			point.x * elements[4] + point.y * elements[5] + point.z * elements[6] + elements[7],
+			point.x * elements[8] + point.y * elements[9] + point.z * elements[10] + elements[11]);
+	}
+
+	// Direction with w = 0, the translation doesn't apply
+	constexpr vec3<Type> TransformVector(const vec3<Type>& vector) const
+	{
+		return vec3<Type>(vector.x * elements[0] + vector.y * elements[1] + vector.z * elements[2],
+			vector.x * elements[4] + vector.y * elements[5] + vector.z * elements[6],
+			vector.x * elements[8] + vector.y * elements[9] + vector.z * elements[10]);
+	}
+
+	/*
+		this then other, like Matrix4 products of row vectors. Column c of the result is the columns of
+		this weighted by column c of other, plus the translation of other on the translation row
+	*/
+	constexpr AffineMatrix4 operator * (const AffineMatrix4& other) const
+	{
+		AffineMatrix4 result;
+
+		for (int col = 0; col < 3; ++col)
+		{
+			vec4<Type> column = GetCol(0) * other[col * 4 + 0] + GetCol(1) * other[col * 4 + 1] + GetCol(2) * other[col * 4 + 2];
+			column.w += other[col * 4 + 3];
+
+			result.SetCol(col, column);
+		}
+
+		return result;
+	}
+
+	constexpr Matrix4<Type> operator * (const Matrix4<Type>& other) const
+	{
+		return ToMatrix4() * other;
+	}
+
+	// Determinant of the linear part, also the one of the full matrix
+	constexpr Type Determinant() const
+	{
+		return GetLinear().Determinant();
+	}
+
+	/*
+		v * L + t = v'  gives  v = v' * inverse(L) - t * inverse(L)
+
+		The inverse of L comes from the cofactors of Matrix3, a singular L gives the zero matrix like
+		Matrix4::Inverse.
+	*/
+	constexpr AffineMatrix4 Inverse() const
+	{
+		return Invert(GetLinear().Inverse());
+	}
+
+	// Inverse when the linear part is a rotation, its transpose is its inverse
+	constexpr AffineMatrix4 InverseRigid() const
+	{
+		return Invert(GetLinear().Transpose());
+	}
+
+	static constexpr AffineMatrix4 Translation(Type x, Type y, Type z)
+	{
+		return AffineMatrix4(1, 0, 0, 0, 1, 0, 0, 0, 1, x, y, z);
+	}
+
+	static constexpr AffineMatrix4 Scale(Type x, Type y, Type z)
+	{
+		return AffineMatrix4(x, 0, 0, 0, y, 0, 0, 0, z, 0, 0, 0);
+	}
+
+	// Rotation of angle radians around axis, same matrix as Matrix4::CreateRotationMatrix
+	static AffineMatrix4 Rotation(const vec3<Type>& axis, float angle)
+	{
+		return AffineMatrix4(Matrix3<Type>::Rotation(axis, angle), vec3<Type>());
+	}
+
+	static const AffineMatrix4 IDENTITY;
+
+private:
+	// Inverse from the inverse of the linear part, the translation is moved through it
+	constexpr AffineMatrix4 Invert(const Matrix3<Type>& inverseLinear) const
+	{
+		vec3<Type> translation = inverseLinear * GetTranslation();
+
+		return AffineMatrix4(inverseLinear, vec3<Type>(-translation.x, -translation.y, -translation.z));
+	}
+};
+
+template <class Type>
+constexpr AffineMatrix4<Type> AffineMatrix4<Type>::IDENTITY = AffineMatrix4<Type>(1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0);
+
+static_assert(std::is_trivially_copyable<AffineMatrix4<float>>::value, "AffineMatrix4 is copied as plain memory");
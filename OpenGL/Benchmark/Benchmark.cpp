@@ -0,0 +1,211 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    double TimeIterations(const BenchmarkRunner::Function& function, uint64_t iterations)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function(iterations);
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    // Nearest rank percentile of sorted values
+    double Percentile(const std::vector<double>& sorted, double percent)
+    {
+        size_t rank = (size_t)std::ceil(percent / 100.0 * sorted.size());
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    // Value with a unit prefix picked so it prints with a few significant digits
+    std::string FormatScaled(double value, const char* const prefixes[], int prefixCount, double step)
+    {
+        int prefix = 0;
+        while (prefix + 1 < prefixCount && std::abs(value) >= step)
+        {
+            value /= step;
+            ++prefix;
+        }
+
+        char text[32];
+        snprintf(text, sizeof(text), "%8.2f %s", value, prefixes[prefix]);
+        return text;
+    }
+
+    std::string FormatTime(double ns)
+    {
+        static const char* const units[] = { "ns", "us", "ms", "s" };
+        return FormatScaled(ns, units, 4, 1000.0);
+    }
+
+    std::string FormatRate(double perSecond, const std::string& name)
+    {
+        static const char* const prefixes[] = { "", "k ", "M ", "G " };
+        return FormatScaled(perSecond, prefixes, 4, 1000.0) + name + "/s";
+    }
+
+    void WriteJsonString(std::ostream& os, const std::string& value)
+    {
+        os << '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\';
+            os << c;
+        }
+        os << '"';
+    }
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options)
+    : options(options)
+{
+}
+
+void BenchmarkRunner::Run(const std::string& name, const Function& function, double itemsPerIteration)
+{
+    std::vector<BenchmarkCounter> counters;
+    if (itemsPerIteration > 0.0)
+        counters.push_back({ "items", itemsPerIteration });
+
+    Run(name, function, counters);
+}
+
+void BenchmarkRunner::Run(const std::string& name, const Function& function, const std::vector<BenchmarkCounter>& counters)
+{
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+        return;
+
+    // Calibrate, every doubling also warms caches and branch predictors
+    double minSampleNs = options.minSampleMs * 1e6;
+    uint64_t iterations = 1;
+    while (TimeIterations(function, iterations) < minSampleNs && iterations < (1ull << 32))
+        iterations *= 2;
+
+    for (uint32_t i = 0; i < options.warmupSamples; ++i)
+        TimeIterations(function, iterations);
+
+    std::vector<double> samples(std::max<uint32_t>(options.samples, 1));
+    for (double& sample : samples)
+        sample = TimeIterations(function, iterations) / iterations;
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = (uint32_t)samples.size();
+    result.medianNs = Percentile(samples, 50.0);
+    result.p99Ns = Percentile(samples, 99.0);
+    result.minNs = samples.front();
+    result.meanNs = 0.0;
+    for (double sample : samples)
+        result.meanNs += sample;
+    result.meanNs /= samples.size();
+    result.counters = counters;
+
+    results.push_back(result);
+    Print(std::cout, results.back());
+}
+
+void BenchmarkRunner::Print(std::ostream& os) const
+{
+    for (const BenchmarkResult& result : results)
+        Print(os, result);
+}
+
+void BenchmarkRunner::Print(std::ostream& os, const BenchmarkResult& result)
+{
+    os << std::left << std::setw(44) << result.name << std::right
+        << "  median " << FormatTime(result.medianNs)
+        << "  p99 " << FormatTime(result.p99Ns);
+
+    for (const BenchmarkCounter& counter : result.counters)
+        os << "  " << FormatRate(counter.perIteration / result.medianNs * 1e9, counter.name);
+
+    os << std::endl;
+}
+
+bool BenchmarkRunner::WriteJson(const std::string& filename, const std::string& suite) const
+{
+    std::ofstream out(filename);
+    if (!out)
+        return false;
+
+    out << std::setprecision(17);
+    out << "{\n  \"suite\": ";
+    WriteJsonString(out, suite);
+    out << ",\n  \"seed\": " << BENCHMARK_SEED << ",\n  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& result = results[i];
+        out << "    {\"name\": ";
+        WriteJsonString(out, result.name);
+        out << ", \"iterations\": " << result.iterations
+            << ", \"samples\": " << result.samples
+            << ", \"median_ns\": " << result.medianNs
+            << ", \"p99_ns\": " << result.p99Ns
+            << ", \"min_ns\": " << result.minNs
+            << ", \"mean_ns\": " << result.meanNs;
+
+        // Rates use the median time, same as the printed table
+        for (const BenchmarkCounter& counter : result.counters)
+        {
+            out << ", ";
+            WriteJsonString(out, counter.name + "_per_iteration");
+            out << ": " << counter.perIteration << ", ";
+            WriteJsonString(out, counter.name + "_per_second");
+            out << ": " << counter.perIteration / result.medianNs * 1e9;
+        }
+
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+    return (bool)out;
+}
+
+bool ParseBenchmarkArguments(int argc, char** argv, BenchmarkOptions& options, std::string& jsonFile, std::vector<std::string>* extraArguments)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(argv[i], "--samples") == 0 && value)
+            options.samples = (uint32_t)std::atoi(value);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && value)
+            options.warmupSamples = (uint32_t)std::atoi(value);
+        else if (std::strcmp(argv[i], "--min-ms") == 0 && value)
+            options.minSampleMs = std::atof(value);
+        else if (std::strcmp(argv[i], "--filter") == 0 && value)
+            options.filter = value;
+        else if (std::strcmp(argv[i], "--json") == 0 && value)
+            jsonFile = value;
+        else if (extraArguments)
+        {
+            extraArguments->push_back(argv[i]);
+            continue;
+        }
+        else
+        {
+            std::cerr << "Unknown argument " << argv[i] << std::endl
+                << "Usage: " << argv[0] << " [--samples n] [--warmup n] [--min-ms ms] [--filter name] [--json file]" << std::endl;
+            return false;
+        }
+
+        ++i;
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Seed used by every benchmark so runs on different commits see the same inputs
+const uint32_t BENCHMARK_SEED = 1234;
+
+// Keeps the compiler from removing a computation whose result is otherwise unused
+template <class Type>
+inline void DoNotOptimize(const Type& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+// Amount of work done by one iteration, reported as a rate next to the timings
+struct BenchmarkCounter
+{
+	std::string name;
+	double perIteration;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	uint64_t iterations;	// Iterations timed per sample
+	uint32_t samples;
+	double medianNs;		// Per iteration
+	double p99Ns;
+	double minNs;
+	double meanNs;
+	std::vector<BenchmarkCounter> counters;
+};
+
+struct BenchmarkOptions
+{
+	uint32_t samples = 51;
+	uint32_t warmupSamples = 5;
+	double minSampleMs = 2.0;	// Iterations per sample grow until a sample takes at least this long
+	std::string filter;			// Only run the benchmarks whose name contains it
+};
+
+/*
+	Runs small timed loops and collects per iteration statistics.
+	The iteration count of a benchmark is calibrated during warmup and then
+	kept for every sample, so the median and p99 come from the same amount of work.
+*/
+class BenchmarkRunner
+{
+public:
+	typedef std::function<void(uint64_t iterations)> Function;
+
+	BenchmarkRunner(const BenchmarkOptions& options);
+
+	// Skipped when the name does not match the filter, itemsPerIteration is used for the throughput column
+	void Run(const std::string& name, const Function& function, double itemsPerIteration = 0.0);
+	void Run(const std::string& name, const Function& function, const std::vector<BenchmarkCounter>& counters);
+
+	const std::vector<BenchmarkResult>& GetResults() const
+	{
+		return results;
+	}
+
+	void Print(std::ostream& os) const;
+	bool WriteJson(const std::string& filename, const std::string& suite) const;
+
+private:
+	static void Print(std::ostream& os, const BenchmarkResult& result);
+
+	BenchmarkOptions options;
+	std::vector<BenchmarkResult> results;
+};
+
+// Parses --samples, --warmup, --min-ms, --filter and --json. Other arguments are appended to extraArguments,
+// without it an unknown argument prints the usage and returns false
+bool ParseBenchmarkArguments(int argc, char** argv, BenchmarkOptions& options, std::string& jsonFile, std::vector<std::string>* extraArguments = nullptr);
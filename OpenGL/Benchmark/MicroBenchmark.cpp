@@ -0,0 +1,1530 @@
+#include "Benchmark.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Triangle.h"
+#include "Clipper.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "Bvh.h"
+#include "Picking.h"
+#include "OcclusionBuffer.h"
+#include "SceneGraph.h"
+#include "FrameArena.h"
+#include "Rasterizer.h"
+#include "Kernels.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "Blend.h"
+#include "TileBinner.h"
+#include "JobSystem.h"
+#include "ClearMetadata.h"
+#include "Msaa.h"
+#include "tgaimage.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Inputs are cycled through so the loops can not be folded into a single evaluation
+    const size_t INPUT_COUNT = 256;
+
+    float RandomFloat(std::mt19937& random, float min, float max)
+    {
+        return std::uniform_real_distribution<float>(min, max)(random);
+    }
+
+    vec3f RandomVec3(std::mt19937& random)
+    {
+        return vec3f(RandomFloat(random, -10, 10), RandomFloat(random, -10, 10), RandomFloat(random, -10, 10));
+    }
+
+    vec4f RandomVec4(std::mt19937& random)
+    {
+        return vec4f(RandomFloat(random, -10, 10), RandomFloat(random, -10, 10), RandomFloat(random, -10, 10), RandomFloat(random, -10, 10));
+    }
+
+    // Random rotation and translation, always invertible
+    mat4f RandomTransform(std::mt19937& random)
+    {
+        mat4f rotation;
+        mat4f::CreateRotationMatrix(rotation, RandomVec3(random).Normalized(), RandomFloat(random, 0, 6.28f));
+
+        mat4f translation;
+        mat4f::CreateTranslationMatrix(translation, RandomFloat(random, -10, 10), RandomFloat(random, -10, 10), RandomFloat(random, -10, 10));
+
+        return rotation * translation;
+    }
+
+    // Unit sphere around center, the triangles face outwards
+    Mesh CreateSphere(int stacks, int slices, const vec3f& center)
+    {
+        Mesh mesh;
+        for (int stack = 0; stack <= stacks; ++stack)
+        {
+            float phi = 3.1415926f * stack / stacks;
+            for (int slice = 0; slice <= slices; ++slice)
+            {
+                float theta = 2 * 3.1415926f * slice / slices;
+                mesh.positions.push_back(vec3f(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta)) + center);
+            }
+        }
+
+        for (int stack = 0; stack < stacks; ++stack)
+        {
+            for (int slice = 0; slice < slices; ++slice)
+            {
+                uint32_t top = stack * (slices + 1) + slice;
+                uint32_t bottom = top + slices + 1;
+                mesh.indices.insert(mesh.indices.end(), { bottom + 1, top, bottom, bottom + 1, top + 1, top });
+            }
+        }
+
+        return mesh;
+    }
+
+    void RegisterMathBenchmarks(BenchmarkRunner& runner)
+    {
+        std::mt19937 random(BENCHMARK_SEED);
+
+        std::vector<mat4f> matrices;
+        std::vector<affine4f> affineMatrices;
+        std::vector<vec4f> vectors4;
+        std::vector<vec3f> vectors3;
+        for (size_t i = 0; i < INPUT_COUNT; ++i)
+        {
+            matrices.push_back(RandomTransform(random));
+            affineMatrices.push_back(affine4f(matrices.back()));
+            vectors4.push_back(RandomVec4(random));
+            vectors3.push_back(RandomVec3(random));
+        }
+
+        const perspective4f perspective = perspective4f::FromFieldOfView(1.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+        const mat4f projection = perspective.ToMatrix4();
+
+        runner.Run("Matrix4/Multiply", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                mat4f result = matrices[i % INPUT_COUNT] * matrices[(i + 1) % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Matrix4/MultiplyVector", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec4f result = matrices[i % INPUT_COUNT] * vectors4[(i + 1) % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Matrix4/Inverse", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                mat4f result = matrices[i % INPUT_COUNT].Inverse();
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Matrix4/Transpose", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                mat4f result = matrices[i % INPUT_COUNT].Transpose();
+                DoNotOptimize(result);
+            }
+        });
+
+        // Same transforms through the structured types, the Matrix4 entries above are the baseline
+        runner.Run("Affine/Multiply", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                affine4f result = affineMatrices[i % INPUT_COUNT] * affineMatrices[(i + 1) % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Affine/MultiplyVector", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec4f result = affineMatrices[i % INPUT_COUNT] * vectors4[(i + 1) % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Affine/Inverse", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                affine4f result = affineMatrices[i % INPUT_COUNT].Inverse();
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Affine/InverseRigid", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                affine4f result = affineMatrices[i % INPUT_COUNT].InverseRigid();
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Perspective/MultiplyVector/Matrix4", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec4f result = projection * vectors4[i % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Perspective/MultiplyVector/Structured", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec4f result = perspective * vectors4[i % INPUT_COUNT];
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Perspective/ModelViewProjection/Matrix4", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                mat4f result = matrices[i % INPUT_COUNT] * projection;
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("Perspective/ModelViewProjection/Structured", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                mat4f result = affineMatrices[i % INPUT_COUNT] * perspective;
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec3/AddScale", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec3f result = vectors3[i % INPUT_COUNT] + vectors3[(i + 1) % INPUT_COUNT] * 0.5f;
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec3/Cross", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec3f result = vec3f::Cross(vectors3[i % INPUT_COUNT], vectors3[(i + 1) % INPUT_COUNT]);
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec3/Normalized", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec3f result = vectors3[i % INPUT_COUNT].Normalized();
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec4/Lerp", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                const vec4f& a = vectors4[i % INPUT_COUNT];
+                const vec4f& b = vectors4[(i + 1) % INPUT_COUNT];
+                vec4f result = a + (b - a) * 0.25f;
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec4/LerpFused", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec4f result = Lerp(vectors4[i % INPUT_COUNT], vectors4[(i + 1) % INPUT_COUNT], 0.25f);
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec3/WeightedSum3", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                const vec3f& a = vectors3[i % INPUT_COUNT];
+                const vec3f& b = vectors3[(i + 1) % INPUT_COUNT];
+                const vec3f& c = vectors3[(i + 2) % INPUT_COUNT];
+                vec3f result = a * 0.2f + b * 0.3f + c * 0.5f;
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec3/WeightedSum3Fused", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                vec3f result = WeightedSum3(vectors3[i % INPUT_COUNT], vectors3[(i + 1) % INPUT_COUNT], vectors3[(i + 2) % INPUT_COUNT], 0.2f, 0.3f, 0.5f);
+                DoNotOptimize(result);
+            }
+        });
+
+        runner.Run("vec4/Dot", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                float result = vectors4[i % INPUT_COUNT].Dot(vectors4[(i + 1) % INPUT_COUNT]);
+                DoNotOptimize(result);
+            }
+        });
+    }
+
+    // A clip space point on the inside or the outside of plane, jittered so every triangle differs
+    vec4f ClipPoint(std::mt19937& random, Plane plane, bool inside)
+    {
+        vec4f point(RandomFloat(random, -0.5f, 0.5f), RandomFloat(random, -0.5f, 0.5f), RandomFloat(random, -0.5f, 0.5f), 1.0f);
+        if (inside)
+            return point;
+
+        float offset = RandomFloat(random, 1.5f, 3.0f);
+        switch (plane)
+        {
+        case Plane::POSITIVEW: point.w = -offset; break;
+        case Plane::RIGHT: point.x = offset; break;
+        case Plane::LEFT: point.x = -offset; break;
+        case Plane::TOP: point.y = offset; break;
+        case Plane::BOTTOM: point.y = -offset; break;
+        case Plane::FAR: point.z = offset; break;
+        case Plane::NEAR: point.z = -offset; break;
+        }
+
+        return point;
+    }
+
+    void RegisterClipBenchmarks(BenchmarkRunner& runner)
+    {
+        const char* planeNames[] = { "PositiveW", "Right", "Left", "Top", "Bottom", "Far", "Near" };
+
+        // Number of vertices inside the plane, covers the accept, reject, one and two output triangle cases
+        const char* caseNames[] = { "AllOutside", "OneInside", "TwoInside", "AllInside" };
+
+        LinearArena arena(64 * 1024);
+
+        for (int plane = 0; plane <= (int)Plane::NEAR; ++plane)
+        {
+            for (int insideCount = 0; insideCount <= 3; ++insideCount)
+            {
+                std::mt19937 random(BENCHMARK_SEED);
+
+                std::vector<Triangle> triangles;
+                for (size_t i = 0; i < INPUT_COUNT; ++i)
+                {
+                    vec4f v0 = ClipPoint(random, (Plane)plane, insideCount > 0);
+                    vec4f v1 = ClipPoint(random, (Plane)plane, insideCount > 1);
+                    vec4f v2 = ClipPoint(random, (Plane)plane, insideCount > 2);
+                    triangles.push_back(Triangle(v0, v1, v2));
+                }
+
+                std::string name = std::string("ClipAgainstPlane/") + planeNames[plane] + "/" + caseNames[insideCount];
+                runner.Run(name, [&](uint64_t iterations)
+                {
+                    for (uint64_t i = 0; i < iterations; i += INPUT_COUNT)
+                    {
+                        TriangleList outList{ ArenaAllocator<Triangle>(&arena) };
+
+                        uint64_t count = std::min<uint64_t>(INPUT_COUNT, iterations - i);
+                        for (uint64_t j = 0; j < count; ++j)
+                            ClipAgainstPlane(triangles[j], outList, (Plane)plane);
+
+                        DoNotOptimize(outList.size());
+                        outList.clear();
+                        arena.Reset();
+                    }
+                });
+            }
+        }
+
+        // Every plane and case mixed, mostly inside like a typical frame
+        std::mt19937 random(BENCHMARK_SEED);
+        std::uniform_int_distribution<int> planeDistribution(0, (int)Plane::NEAR);
+
+        TriangleBatch mixed;
+        for (size_t i = 0; i < INPUT_COUNT; ++i)
+        {
+            Plane plane = (Plane)planeDistribution(random);
+            int insideCount = (i % 4 == 0) ? (int)(i / 4 % 3) : 3;
+
+            vec4f v0 = ClipPoint(random, plane, insideCount > 0);
+            vec4f v1 = ClipPoint(random, plane, insideCount > 1);
+            vec4f v2 = ClipPoint(random, plane, insideCount > 2);
+            mixed.Add(Triangle(v0, v1, v2), (uint32_t)i);
+        }
+
+        // Every triangle crossing the near plane, like a camera close to the ground
+        TriangleBatch nearCrossing;
+        for (size_t i = 0; i < INPUT_COUNT; ++i)
+        {
+            int insideCount = 1 + (int)(i % 2);
+
+            vec4f v0 = ClipPoint(random, Plane::NEAR, insideCount > 0);
+            vec4f v1 = ClipPoint(random, Plane::NEAR, insideCount > 1);
+            vec4f v2 = ClipPoint(random, Plane::NEAR, insideCount > 2);
+            nearCrossing.Add(Triangle(v0, v1, v2), (uint32_t)i);
+        }
+
+        BatchClipper clipper;
+        TriangleBatch clipped;
+
+        auto registerClippers = [&](const std::string& caseName, const TriangleBatch& triangles)
+        {
+            runner.Run("ClipTriangle/" + caseName, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; i += INPUT_COUNT)
+                {
+                    TriangleList outList{ ArenaAllocator<Triangle>(&arena) };
+
+                    uint64_t count = std::min<uint64_t>(INPUT_COUNT, iterations - i);
+                    for (uint64_t j = 0; j < count; ++j)
+                        ClipTriangle(triangles.GetTriangle(j), outList);
+
+                    DoNotOptimize(outList.size());
+                    outList.clear();
+                    arena.Reset();
+                }
+            });
+
+            runner.Run("BatchClipper/" + caseName, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; i += INPUT_COUNT)
+                {
+                    clipped.Clear();
+                    clipper.Clip(triangles, clipped);
+
+                    DoNotOptimize(clipped.Size());
+                }
+            });
+        };
+
+        registerClippers("Mixed", mixed);
+        registerClippers("NearCrossing", nearCrossing);
+    }
+
+    // Objects scattered all around the camera, most of them outside of the 60 degree frustum like in a large scene
+    void RegisterCullBenchmarks(BenchmarkRunner& runner)
+    {
+        const size_t OBJECT_COUNT = 4096;
+        std::mt19937 random(BENCHMARK_SEED);
+
+        std::vector<AABB> boxes;
+        std::vector<BoundingSphere> spheres;
+        BoundsBatch bounds;
+        for (size_t i = 0; i < OBJECT_COUNT; ++i)
+        {
+            vec3f center = RandomVec3(random) * 10.0f;
+            vec3f halfSize(RandomFloat(random, 0.5f, 4.0f), RandomFloat(random, 0.5f, 4.0f), RandomFloat(random, 0.5f, 4.0f));
+
+            boxes.push_back(AABB(center - halfSize, center + halfSize));
+            spheres.push_back(BoundingSphere(center, halfSize.Magnitude()));
+            bounds.Add(boxes.back());
+        }
+
+        const Frustum frustum(perspective4f::FromFieldOfView(60.0f * 3.1415926f / 180.0f, 4.0f / 3.0f, 0.03f, 1000.0f).ToMatrix4());
+        const std::vector<BenchmarkCounter> counters = { { "objects", (double)OBJECT_COUNT } };
+
+        runner.Run("Cull/IsVisible/Sphere", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                size_t visibleCount = 0;
+                for (const BoundingSphere& sphere : spheres)
+                    visibleCount += frustum.IsVisible(sphere);
+
+                DoNotOptimize(visibleCount);
+            }
+        }, counters);
+
+        runner.Run("Cull/IsVisible/Box", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                size_t visibleCount = 0;
+                for (const AABB& box : boxes)
+                    visibleCount += frustum.IsVisible(box);
+
+                DoNotOptimize(visibleCount);
+            }
+        }, counters);
+
+        std::vector<uint32_t> visible;
+        runner.Run("Cull/CullBounds", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                visible.clear();
+                DoNotOptimize(CullBounds(frustum, bounds, visible));
+            }
+        }, counters);
+
+        Bvh bvh;
+        bvh.Build(boxes);
+
+        runner.Run("Bvh/Build", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                bvh.Build(boxes);
+
+            DoNotOptimize(bvh.GetNodes().size());
+        }, counters);
+
+        runner.Run("Cull/Bvh", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                visible.clear();
+                DoNotOptimize(bvh.Cull(frustum, visible));
+            }
+        }, counters);
+
+        // A few objects move each frame
+        std::vector<AABB> movedBoxes = boxes;
+        std::vector<uint32_t> moved;
+        for (size_t i = 0; i < OBJECT_COUNT / 50; ++i)
+            moved.push_back((uint32_t)(random() % OBJECT_COUNT));
+
+        runner.Run("Bvh/Refit/All", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                bvh.Refit(movedBoxes);
+
+            DoNotOptimize(bvh.GetNodes()[0].bounds);
+        }, counters);
+
+        runner.Run("Bvh/Refit/Moved", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                // Back and forth so the boxes stay in place over the run
+                const float offset = (i & 1) ? -0.5f : 0.5f;
+                for (uint32_t item : moved)
+                {
+                    movedBoxes[item].min.x += offset;
+                    movedBoxes[item].max.x += offset;
+                }
+
+                bvh.Refit(movedBoxes, moved);
+            }
+
+            DoNotOptimize(bvh.GetNodes()[0].bounds);
+        }, counters);
+
+        std::vector<uint8_t> flags(OBJECT_COUNT);
+        const BoundsArrays arrays = bounds.GetArrays();
+
+        for (int isa = 0; isa < (int)KernelIsa::COUNT; ++isa)
+        {
+            const Kernels* kernels = GetKernels((KernelIsa)isa);
+            if (!kernels)
+                continue;
+
+            runner.Run(std::string("Kernels/CullBounds/") + GetKernelIsaName((KernelIsa)isa), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                    DoNotOptimize(kernels->CullBounds(frustum.GetPlanes(), arrays, flags.data()));
+            }, counters);
+        }
+    }
+
+    // A wall in front of the camera hiding part of a field of boxes
+    void RegisterOcclusionBenchmarks(BenchmarkRunner& runner)
+    {
+        const size_t OBJECT_COUNT = 4096;
+
+        Mesh wall;
+        wall.positions = { vec3f(-6, -3, -10), vec3f(6, -3, -10), vec3f(6, 3, -10), vec3f(-6, 3, -10) };
+        wall.colors.assign(wall.positions.size(), vec3f(1, 1, 1));
+        wall.indices = { 0, 3, 2, 0, 2, 1 };
+
+        const mat4f projection = perspective4f::FromFieldOfView(60.0f * 3.1415926f / 180.0f, 2.0f, 0.03f, 1000.0f).ToMatrix4();
+
+        std::mt19937 random(BENCHMARK_SEED);
+        std::vector<AABB> boxes;
+        for (size_t i = 0; i < OBJECT_COUNT; ++i)
+        {
+            vec3f center(RandomFloat(random, -8, 8), RandomFloat(random, -4, 4), RandomFloat(random, -30, -3));
+            vec3f halfSize(RandomFloat(random, 0.1f, 1.0f), RandomFloat(random, 0.1f, 1.0f), RandomFloat(random, 0.1f, 1.0f));
+            boxes.push_back(AABB(center - halfSize, center + halfSize));
+        }
+
+        OcclusionBuffer occlusion;
+
+        runner.Run("Occlusion/AddOccluder", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                occlusion.Clear();
+                occlusion.AddOccluder(wall, projection);
+            }
+
+            DoNotOptimize(occlusion.GetDepth(0, 0));
+        }, { { "pixels", (double)OcclusionBuffer::DEFAULT_WIDTH * OcclusionBuffer::DEFAULT_HEIGHT } });
+
+        runner.Run("Occlusion/IsVisible", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                size_t visibleCount = 0;
+                for (const AABB& box : boxes)
+                    visibleCount += occlusion.IsVisible(box, projection);
+
+                DoNotOptimize(visibleCount);
+            }
+        }, { { "objects", (double)OBJECT_COUNT } });
+    }
+
+    // Pixel to triangle queries on a dense sphere in front of the camera
+    void RegisterPickBenchmarks(BenchmarkRunner& runner)
+    {
+        const int STACKS = 128;
+        const int SLICES = 256;
+        const int IMAGE_SIZE = 256;
+
+        const Mesh mesh = CreateSphere(STACKS, SLICES, vec3f(0, 0, -3));
+
+        const mat4f projection = perspective4f::FromFieldOfView(60.0f * 3.1415926f / 180.0f, 1.0f, 0.03f, 1000.0f).ToMatrix4();
+
+        std::mt19937 random(BENCHMARK_SEED);
+        std::vector<Ray> rays;
+        for (size_t i = 0; i < INPUT_COUNT; ++i)
+            rays.push_back(GetRasterRay(projection, RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), IMAGE_SIZE, IMAGE_SIZE));
+
+        const std::vector<BenchmarkCounter> counters = { { "triangles", (double)mesh.GetTriangleCount() } };
+
+        MeshPicker picker(mesh);
+        runner.Run("Pick/Bvh", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                PickHit hit;
+                DoNotOptimize(picker.Pick(rays[i % INPUT_COUNT], hit));
+            }
+        }, counters);
+
+        runner.Run("Pick/BruteForce", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                const Ray& ray = rays[i % INPUT_COUNT];
+
+                float closest = FLT_MAX;
+                uint32_t closestTriangle = UINT32_MAX;
+                for (size_t triangle = 0; triangle < mesh.GetTriangleCount(); ++triangle)
+                {
+                    float distance, u, v;
+                    if (IntersectRayTriangle(ray, mesh.positions[mesh.indices[triangle * 3]], mesh.positions[mesh.indices[triangle * 3 + 1]],
+                        mesh.positions[mesh.indices[triangle * 3 + 2]], closest, distance, u, v))
+                    {
+                        closest = distance;
+                        closestTriangle = (uint32_t)triangle;
+                    }
+                }
+
+                DoNotOptimize(closestTriangle);
+            }
+        }, counters);
+    }
+
+    // A field of small spheres around the camera, drawn with one ProcessGeometry per copy and as instances
+    void RegisterInstanceBenchmarks(BenchmarkRunner& runner)
+    {
+        const size_t INSTANCE_COUNT = 4096;
+        const int IMAGE_SIZE = 512;
+
+        Mesh mesh = CreateSphere(8, 16, vec3f());
+        for (const vec3f& position : mesh.positions)
+            mesh.colors.push_back(position * 0.5f + vec3f(0.5f, 0.5f, 0.5f));
+
+        std::mt19937 random(BENCHMARK_SEED);
+        std::vector<affine4f> instances;
+        for (size_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            const float scale = RandomFloat(random, 0.2f, 0.6f);
+            instances.push_back(affine4f::Scale(scale, scale, scale) * affine4f::Rotation(vec3f(0, 1, 0), RandomFloat(random, 0, 6.28f))
+                * affine4f::Translation(RandomFloat(random, -40, 40), RandomFloat(random, -2, 2), RandomFloat(random, -40, 40)));
+        }
+
+        const mat4f viewProjection = perspective4f::FromFieldOfView(60.0f * 3.1415926f / 180.0f, 1.0f, 0.03f, 1000.0f).ToMatrix4();
+        const std::vector<BenchmarkCounter> counters = { { "instances", (double)INSTANCE_COUNT } };
+
+        GeometryContext geometry;
+        TriangleBatch triangles;
+        runner.Run("Instances/Loop", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                triangles.Clear();
+                for (const affine4f& instance : instances)
+                    ProcessGeometry(geometry, mesh, instance * viewProjection, IMAGE_SIZE, IMAGE_SIZE, triangles);
+
+                DoNotOptimize(triangles.Size());
+            }
+        }, counters);
+
+        runner.Run("Instances/ProcessInstances", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                triangles.Clear();
+                DoNotOptimize(ProcessInstances(geometry, mesh, instances.data(), instances.size(), viewProjection, IMAGE_SIZE, IMAGE_SIZE, triangles));
+            }
+        }, counters);
+
+        std::vector<float> models(INSTANCE_COUNT * 12);
+        for (size_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            for (int element = 0; element < 12; ++element)
+                models[i * 12 + element] = instances[i][element];
+        }
+
+        float matrix[16];
+        GetKernelMatrix(viewProjection, matrix);
+        std::vector<float> matrices(INSTANCE_COUNT * 16);
+
+        for (int isa = 0; isa < (int)KernelIsa::COUNT; ++isa)
+        {
+            const Kernels* kernels = GetKernels((KernelIsa)isa);
+            if (!kernels)
+                continue;
+
+            runner.Run(std::string("Kernels/ComposeMatrices/") + GetKernelIsaName((KernelIsa)isa), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    kernels->ComposeMatrices(matrix, models.data(), INSTANCE_COUNT, matrices.data());
+                    DoNotOptimize(matrices[0]);
+                }
+            }, counters);
+        }
+    }
+
+    // Skeletons of a crowd where a few bones move per frame, against moving every node
+    void RegisterSceneGraphBenchmarks(BenchmarkRunner& runner)
+    {
+        const int SKELETON_COUNT = 256;
+        const int BONE_COUNT = 64;
+        const size_t MOVED_COUNT = SKELETON_COUNT * BONE_COUNT / 50;
+
+        std::mt19937 random(BENCHMARK_SEED);
+        auto randomLocal = [&]()
+        {
+            return trsf(RandomVec3(random) * 0.1f, mat3f::Rotation(RandomVec3(random).Normalized(), RandomFloat(random, 0, 6.28f)), vec3f(1, 1, 1));
+        };
+
+        SceneGraph scene;
+        for (int skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+        {
+            const uint32_t root = scene.AddNode(trsf(RandomVec3(random) * 10.0f, mat3f::IDENTITY, vec3f(1, 1, 1)));
+
+            // Each bone hangs from one of the earlier bones of its skeleton
+            for (int bone = 1; bone < BONE_COUNT; ++bone)
+                scene.AddNode(randomLocal(), root + (uint32_t)(random() % bone));
+        }
+
+        scene.Update();
+
+        std::vector<uint32_t> moved;
+        std::vector<trsf> movedLocals;
+        for (size_t i = 0; i < MOVED_COUNT; ++i)
+        {
+            moved.push_back((uint32_t)(random() % scene.GetNodeCount()));
+            movedLocals.push_back(randomLocal());
+        }
+
+        const std::vector<BenchmarkCounter> counters = { { "nodes", (double)scene.GetNodeCount() } };
+
+        runner.Run("SceneGraph/Update/All", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (uint32_t node = 0; node < (uint32_t)scene.GetNodeCount(); ++node)
+                    scene.SetLocal(node, scene.GetLocal(node));
+
+                scene.Update();
+            }
+
+            DoNotOptimize(scene.GetWorld(0));
+        }, counters);
+
+        runner.Run("SceneGraph/Update/Moved", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (size_t index = 0; index < moved.size(); ++index)
+                    scene.SetLocal(moved[index], movedLocals[index]);
+
+                scene.Update();
+            }
+
+            DoNotOptimize(scene.GetWorld(0));
+        }, counters);
+
+        runner.Run("SceneGraph/Update/Moved/Jobs", [&](uint64_t iterations)
+        {
+            JobSystem jobs(JobSystem::GetDefaultWorkerCount());
+
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (size_t index = 0; index < moved.size(); ++index)
+                    scene.SetLocal(moved[index], movedLocals[index]);
+
+                scene.Update(jobs);
+            }
+
+            DoNotOptimize(scene.GetWorld(0));
+        }, counters);
+    }
+
+    void RegisterRasterBenchmarks(BenchmarkRunner& runner)
+    {
+        const int IMAGE_SIZE = 1024;
+        TGAImage image(IMAGE_SIZE, IMAGE_SIZE, TGAImage::RGB);
+
+        const int sizes[] = { 2, 8, 32, 128, 512 };
+
+        // Width and height divisors, square, wide and tall
+        const struct
+        {
+            const char* name;
+            int widthDivisor;
+            int heightDivisor;
+        } aspects[] = { { "Square", 1, 1 }, { "Wide", 1, 8 }, { "Tall", 8, 1 } };
+
+        for (int size : sizes)
+        {
+            for (const auto& aspect : aspects)
+            {
+                float width = std::max(1.0f, (float)size / aspect.widthDivisor);
+                float height = std::max(1.0f, (float)size / aspect.heightDivisor);
+
+                // Right triangle centered in the image, offset by a fraction of a pixel so edges cut through samples
+                float x = (IMAGE_SIZE - width) * 0.5f + 0.25f;
+                float y = (IMAGE_SIZE - height) * 0.5f + 0.25f;
+
+                vec4f v0(x, y, 0.5f, 1.0f);
+                vec4f v1(x + width, y, 0.5f, 1.0f);
+                vec4f v2(x, y + height, 0.5f, 1.0f);
+
+                // The rasterizer only draws triangles with a negative area
+                if (vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY()) > 0)
+                    std::swap(v1, v2);
+
+                std::string name = "DrawTriangleBC/" + std::to_string(size) + "/" + aspect.name;
+                runner.Run(name, [&](uint64_t iterations)
+                {
+                    for (uint64_t i = 0; i < iterations; ++i)
+                        DrawTriangleBC(image, v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+
+                    DoNotOptimize(*image.buffer());
+                }, { { "pixels", width * height * 0.5 } });
+            }
+        }
+    }
+
+    // Resolve of a multisampled frame of random triangles, most pixels compressed and the edges expanded
+    void RegisterMsaaBenchmarks(BenchmarkRunner& runner)
+    {
+        const int WIDTH = 800;
+        const int HEIGHT = 600;
+        std::mt19937 random(BENCHMARK_SEED);
+
+        TGAImage image(WIDTH, HEIGHT, TGAImage::RGB);
+
+        for (int sampleCount : { 4, 8 })
+        {
+            MsaaTarget target(WIDTH, HEIGHT, sampleCount);
+            target.Clear(TGAColor(0, 0, 0));
+
+            for (int i = 0; i < 64; ++i)
+            {
+                vec4f v0(RandomFloat(random, 0, WIDTH), RandomFloat(random, 0, HEIGHT), 0.5f, 1.0f);
+                vec4f v1(RandomFloat(random, 0, WIDTH), RandomFloat(random, 0, HEIGHT), 0.5f, 1.0f);
+                vec4f v2(RandomFloat(random, 0, WIDTH), RandomFloat(random, 0, HEIGHT), 0.5f, 1.0f);
+                if (vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY()) > 0)
+                    std::swap(v1, v2);
+
+                target.DrawTriangle(v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+            }
+
+            runner.Run("Msaa/Resolve/" + std::to_string(sampleCount) + "x", [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                    target.Resolve(image);
+
+                DoNotOptimize(*image.buffer());
+            }, { { "pixels", (double)WIDTH * HEIGHT } });
+        }
+    }
+
+    void RegisterTgaBenchmarks(BenchmarkRunner& runner)
+    {
+        // Overlapping shaded triangles, a mix of flat runs and gradients like the demo output
+        const int IMAGE_SIZE = 512;
+        TGAImage image(IMAGE_SIZE, IMAGE_SIZE, TGAImage::RGB);
+        ClearTarget(image, IMAGE_SIZE, IMAGE_SIZE, TGAColor(40, 40, 40));
+
+        std::mt19937 random(BENCHMARK_SEED);
+        for (int i = 0; i < 64; ++i)
+        {
+            vec4f v0(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            vec4f v1(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            vec4f v2(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            if (vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY()) > 0)
+                std::swap(v1, v2);
+
+            DrawTriangleBC(image, v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+        }
+
+        const double pixels = (double)IMAGE_SIZE * IMAGE_SIZE;
+
+        for (bool rle : { true, false })
+        {
+            std::string filename = rle ? "MicroBenchmarkRle.tga" : "MicroBenchmarkRaw.tga";
+            std::string suffix = rle ? "Rle" : "Raw";
+
+            runner.Run("TGA/Write" + suffix, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                    image.write_tga_file(filename, true, rle);
+            }, { { "pixels", pixels } });
+
+            // The read benchmark needs the file even when the write benchmark was filtered out
+            image.write_tga_file(filename, true, rle);
+
+            runner.Run("TGA/Read" + suffix, [&](uint64_t iterations)
+            {
+                // read_tga_file logs the image size on every successful read
+                std::streambuf* log = std::cerr.rdbuf(nullptr);
+
+                TGAImage loaded;
+                for (uint64_t i = 0; i < iterations; ++i)
+                    loaded.read_tga_file(filename);
+
+                std::cerr.rdbuf(log);
+                std::cerr.clear();
+
+                DoNotOptimize(*loaded.buffer());
+            }, { { "pixels", pixels } });
+
+            std::remove(filename.c_str());
+        }
+    }
+
+    // Vertex colors behind a virtual call per vertex and per pixel
+    class VertexColorProgram : public ShaderProgram
+    {
+    public:
+        VertexColorProgram(const Mesh& mesh, const mat4f& modelViewProjection)
+            : vertexShader(mesh, modelViewProjection)
+        {}
+
+        int GetVaryingCount() const override
+        {
+            return MeshVertexShader::VARYING_COUNT;
+        }
+
+        vec4f ShadeVertex(uint32_t vertex, float* varyings) const override
+        {
+            return vertexShader(vertex, varyings);
+        }
+
+        TGAColor ShadeFragment(const float* varyings) const override
+        {
+            return fragmentShader(varyings);
+        }
+
+    private:
+        MeshVertexShader vertexShader;
+        VertexColorShader fragmentShader;
+    };
+
+    // The same mesh through the fixed function pipeline, the templated shaders and the type erased program
+    void RegisterShaderBenchmarks(BenchmarkRunner& runner)
+    {
+        const int IMAGE_SIZE = 512;
+        const int CELLS = 32;
+        TGAImage image(IMAGE_SIZE, IMAGE_SIZE, TGAImage::RGB);
+
+        // Grid in clip space, in front of the far plane
+        Mesh mesh;
+        for (int y = 0; y <= CELLS; ++y)
+        {
+            for (int x = 0; x <= CELLS; ++x)
+            {
+                float px = -0.9f + 1.8f * x / CELLS;
+                float py = -0.9f + 1.8f * y / CELLS;
+                mesh.positions.push_back(vec3f(px, py, 0.5f));
+                mesh.colors.push_back(vec3f((px + 1) * 0.5f, (py + 1) * 0.5f, 0.5f));
+            }
+        }
+
+        for (int y = 0; y < CELLS; ++y)
+        {
+            for (int x = 0; x < CELLS; ++x)
+            {
+                uint32_t bottomLeft = y * (CELLS + 1) + x;
+                uint32_t topLeft = bottomLeft + CELLS + 1;
+                mesh.indices.insert(mesh.indices.end(), { bottomLeft, topLeft, topLeft + 1, bottomLeft, topLeft + 1, bottomLeft + 1 });
+            }
+        }
+
+        mat4f identity;
+        mat4f::CreateTranslationMatrix(identity, 0, 0, 0);
+
+        const double pixels = 0.9 * IMAGE_SIZE * 0.9 * IMAGE_SIZE;
+        GeometryContext geometry;
+        TriangleBatch triangles;
+
+        runner.Run("Shader/FixedFunction", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                triangles.Clear();
+                ProcessGeometry(geometry, mesh, identity, IMAGE_SIZE, IMAGE_SIZE, triangles);
+                RasterizeTriangles(image, triangles);
+            }
+
+            DoNotOptimize(*image.buffer());
+        }, { { "pixels", pixels } });
+
+        MeshVertexShader vertexShader(mesh, identity);
+        VertexColorShader fragmentShader;
+
+        runner.Run("Shader/Template", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                DrawIndexed(image, mesh, vertexShader, fragmentShader);
+
+            DoNotOptimize(*image.buffer());
+        }, { { "pixels", pixels } });
+
+        VertexColorProgram program(mesh, identity);
+
+        runner.Run("Shader/Virtual", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                DrawIndexed(image, mesh, program);
+
+            DoNotOptimize(*image.buffer());
+        }, { { "pixels", pixels } });
+    }
+
+    // Every compiled kernel variant the CPU supports, side by side
+    void RegisterKernelBenchmarks(BenchmarkRunner& runner)
+    {
+        const size_t VERTEX_COUNT = 4096;
+        std::mt19937 random(BENCHMARK_SEED);
+
+        std::vector<vec3f> positions;
+        for (size_t i = 0; i < VERTEX_COUNT; ++i)
+            positions.push_back(RandomVec3(random));
+
+        float matrix[16];
+        GetKernelMatrix(RandomTransform(random), matrix);
+        std::vector<vec4f> clipVertices(VERTEX_COUNT);
+
+        TriangleSetup setup = SetupTriangle(vec4f(0.25f, 0.25f, 0.5f, 1.0f), vec4f(0.25f, 64.25f, 0.5f, 2.0f), vec4f(64.25f, 0.25f, 0.5f, 1.5f),
+            vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+        alignas(64) uint8_t bgra[SPAN_SIZE * 4];
+        alignas(64) uint8_t coverage[SPAN_SIZE];
+
+        // Rendered triangles with flat background, like the frames the demo writes
+        const int IMAGE_SIZE = 512;
+        TGAImage image(IMAGE_SIZE, IMAGE_SIZE, TGAImage::RGB);
+        for (int i = 0; i < 16; ++i)
+        {
+            vec4f v0(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            vec4f v1(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            vec4f v2(RandomFloat(random, 0, IMAGE_SIZE), RandomFloat(random, 0, IMAGE_SIZE), 0.5f, 1.0f);
+            if (vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY()) > 0)
+                std::swap(v1, v2);
+
+            DrawTriangleBC(image, v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+        }
+
+        const size_t pixelCount = (size_t)IMAGE_SIZE * IMAGE_SIZE;
+        std::vector<uint8_t> scratch(pixelCount * 3);
+        std::vector<uint8_t> encoded(pixelCount * 4);
+
+        // Half transparent fragments over every other pixel of a span
+        alignas(64) uint8_t source[SPAN_SIZE * 4];
+        alignas(64) uint8_t destination[SPAN_SIZE * 4];
+        alignas(64) uint8_t blendCoverage[SPAN_SIZE];
+        for (int i = 0; i < SPAN_SIZE * 4; ++i)
+        {
+            source[i] = (uint8_t)random();
+            destination[i] = (uint8_t)random();
+        }
+
+        for (int i = 0; i < SPAN_SIZE; ++i)
+        {
+            source[i * 4 + 3] = 128;
+            blendCoverage[i] = (uint8_t)(i & 1);
+        }
+
+        for (int isa = 0; isa < (int)KernelIsa::COUNT; ++isa)
+        {
+            const Kernels* kernels = GetKernels((KernelIsa)isa);
+            if (!kernels)
+                continue;
+
+            std::string suffix = std::string("/") + GetKernelIsaName((KernelIsa)isa);
+
+            runner.Run("Kernels/TransformPositions" + suffix, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                    kernels->TransformPositions(matrix, positions.data(), clipVertices.data(), VERTEX_COUNT);
+
+                DoNotOptimize(clipVertices[0]);
+            }, { { "vertices", (double)VERTEX_COUNT } });
+
+            runner.Run("Kernels/ShadeSpan" + suffix, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    int covered = kernels->ShadeSpan(setup, (int)(i % 64), 0, SPAN_SIZE, bgra, coverage);
+                    DoNotOptimize(covered);
+                }
+            }, { { "pixels", (double)SPAN_SIZE } });
+
+            runner.Run("Kernels/EncodeRle" + suffix, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    size_t size = kernels->EncodeRle(image.buffer(), pixelCount, 3, scratch.data(), encoded.data());
+                    DoNotOptimize(size);
+                }
+            }, { { "pixels", (double)pixelCount } });
+
+            runner.Run("Kernels/BlendSpan" + suffix, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    kernels->BlendSpan(source, blendCoverage, SPAN_SIZE, BlendMode::ALPHA, destination);
+                    DoNotOptimize(destination[0]);
+                }
+            }, { { "pixels", (double)SPAN_SIZE } });
+        }
+    }
+
+    // Clearing and writing a sparse frame, one triangle over a few tiles, with and without the clear metadata
+    void RegisterFastClearBenchmarks(BenchmarkRunner& runner)
+    {
+        const int WIDTH = 800;
+        const int HEIGHT = 600;
+        const std::string filename = "BenchmarkFastClear.tga";
+
+        TGAImage image(WIDTH, HEIGHT, TGAImage::RGB);
+        ClearMetadata clearMetadata(WIDTH, HEIGHT, TILE_SIZE);
+
+        // Drawn into the image the way the binned rasterizer does, through a tile buffer per tile
+        auto drawTriangle = [&]()
+        {
+            vec4f v0(300.25f, 200.25f, 0.5f, 1.0f);
+            vec4f v1(300.25f, 380.25f, 0.5f, 1.0f);
+            vec4f v2(480.25f, 200.25f, 0.5f, 1.0f);
+
+            TileBuffer tile(TILE_SIZE, TILE_SIZE);
+            for (int index = 0; index < clearMetadata.GetTileCount(); ++index)
+            {
+                ScissorRect rect = clearMetadata.GetTileRect(index);
+                if (rect.maxX < 300 || rect.minX > 480 || rect.maxY < 200 || rect.minY > 380)
+                    continue;
+
+                if (clearMetadata.IsCleared(index))
+                    tile.Fill(rect, clearMetadata.GetClearColor());
+                else
+                    tile.Load(image, rect);
+
+                DrawTriangleBC(tile, v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1), BlendState());
+                tile.Store(image);
+                clearMetadata.MarkWritten(index);
+            }
+        };
+
+        const double pixels = (double)WIDTH * HEIGHT;
+
+        runner.Run("FastClear/ClearTarget", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                ClearTarget(image, WIDTH, HEIGHT, TGAColor(0, 0, 0));
+
+            DoNotOptimize(*image.buffer());
+        }, { { "pixels", pixels } });
+
+        runner.Run("FastClear/Clear", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                clearMetadata.Clear(TGAColor(0, 0, 0));
+                DoNotOptimize(clearMetadata);
+            }
+        }, { { "pixels", pixels } });
+
+        clearMetadata.Clear(TGAColor(0, 0, 0));
+        drawTriangle();
+        clearMetadata.Resolve(image);
+        clearMetadata.Clear(TGAColor(0, 0, 0));
+        drawTriangle();
+
+        runner.Run("FastClear/WriteTga", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                image.write_tga_file(filename);
+        }, { { "pixels", pixels } });
+
+        runner.Run("FastClear/WriteTgaMetadata", [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                WriteTgaFile(filename, image, clearMetadata);
+        }, { { "pixels", pixels } });
+
+        std::remove(filename.c_str());
+    }
+
+    // Stacked screen sized quads blended in the tile buffers of the binned rasterizer
+    void RegisterBlendBenchmarks(BenchmarkRunner& runner)
+    {
+        const int IMAGE_SIZE = 512;
+        const int LAYERS = 8;
+
+        Mesh mesh;
+        for (int layer = 0; layer < LAYERS; ++layer)
+        {
+            uint32_t first = (uint32_t)mesh.positions.size();
+            float extent = 0.9f - 0.05f * layer;
+            vec3f color((float)layer / LAYERS, 1 - (float)layer / LAYERS, 0.5f);
+
+            mesh.positions.insert(mesh.positions.end(), { vec3f(-extent, -extent, 0.5f), vec3f(extent, -extent, 0.5f), vec3f(extent, extent, 0.5f), vec3f(-extent, extent, 0.5f) });
+            mesh.colors.insert(mesh.colors.end(), { color, color, color, color });
+            mesh.indices.insert(mesh.indices.end(), { first, first + 3, first + 2, first, first + 2, first + 1 });
+        }
+
+        mat4f identity;
+        mat4f::CreateTranslationMatrix(identity, 0, 0, 0);
+
+        double pixels = 0;
+        for (int layer = 0; layer < LAYERS; ++layer)
+        {
+            float extent = 0.9f - 0.05f * layer;
+            pixels += extent * IMAGE_SIZE * extent * IMAGE_SIZE;
+        }
+
+        const char* modeNames[] = { "Replace", "Alpha", "Additive", "Premultiplied" };
+
+        for (int mode = 0; mode < (int)BlendMode::COUNT; ++mode)
+        {
+            runner.Run(std::string("Blend/Binned/") + modeNames[mode], [&, mode](uint64_t iterations)
+            {
+                JobSystem jobs(0);
+                TileBinner binner(IMAGE_SIZE, IMAGE_SIZE, TILE_SIZE);
+                TGAImage image(IMAGE_SIZE, IMAGE_SIZE, TGAImage::RGB);
+                GeometryContext geometry;
+
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    binner.Reset(jobs.GetThreadCount());
+                    ProcessGeometry(jobs, geometry, mesh, identity, binner, 0, BlendState((BlendMode)mode, 128));
+                    binner.Rasterize(jobs, image);
+                }
+
+                DoNotOptimize(*image.buffer());
+            }, { { "pixels", pixels } });
+        }
+    }
+
+    // Prints the result of one --verify check, returns passed
+    bool ReportCheck(const std::string& name, bool passed, const std::string& detail = std::string())
+    {
+        std::cout << (passed ? "ok     " : "FAILED ") << name;
+        if (!passed && !detail.empty())
+            std::cout << ": " << detail;
+
+        std::cout << std::endl;
+        return passed;
+    }
+
+    // Bvh cull against testing every box, after the build and after both refits, and picking against testing every triangle
+    bool VerifyBvh()
+    {
+        const size_t OBJECT_COUNT = 4096;
+        const int FRUSTUM_COUNT = 16;
+        std::mt19937 random(BENCHMARK_SEED);
+
+        std::vector<AABB> boxes;
+        for (size_t i = 0; i < OBJECT_COUNT; ++i)
+        {
+            vec3f center = RandomVec3(random) * 10.0f;
+            vec3f halfSize(RandomFloat(random, 0.5f, 4.0f), RandomFloat(random, 0.5f, 4.0f), RandomFloat(random, 0.5f, 4.0f));
+            boxes.push_back(AABB(center - halfSize, center + halfSize));
+        }
+
+        std::vector<Frustum> frustums;
+        for (int i = 0; i < FRUSTUM_COUNT; ++i)
+        {
+            const mat4f projection = perspective4f::FromFieldOfView(RandomFloat(random, 0.5f, 2.0f), RandomFloat(random, 0.5f, 2.0f), 0.1f, 200.0f).ToMatrix4();
+            frustums.push_back(Frustum(RandomTransform(random) * projection));
+        }
+
+        Bvh bvh;
+        bvh.Build(boxes);
+
+        auto checkCull = [&](const std::string& name)
+        {
+            for (const Frustum& frustum : frustums)
+            {
+                std::vector<uint32_t> visible;
+                bvh.Cull(frustum, visible);
+                std::sort(visible.begin(), visible.end());
+
+                std::vector<uint32_t> expected;
+                for (uint32_t item = 0; item < (uint32_t)boxes.size(); ++item)
+                {
+                    if (frustum.IsVisible(boxes[item]))
+                        expected.push_back(item);
+                }
+
+                if (visible != expected)
+                    return ReportCheck(name, false, std::to_string(visible.size()) + " visible instead of " + std::to_string(expected.size()));
+            }
+
+            return ReportCheck(name, true);
+        };
+
+        bool passed = checkCull("Bvh/Cull/Build");
+
+        std::vector<uint32_t> moved;
+        for (size_t i = 0; i < OBJECT_COUNT / 20; ++i)
+        {
+            const uint32_t item = (uint32_t)(random() % OBJECT_COUNT);
+            const vec3f offset = RandomVec3(random);
+
+            boxes[item] = AABB(boxes[item].min + offset, boxes[item].max + offset);
+            moved.push_back(item);
+        }
+
+        bvh.Refit(boxes, moved);
+        passed = checkCull("Bvh/Cull/RefitMoved") && passed;
+
+        for (AABB& box : boxes)
+        {
+            const vec3f offset = RandomVec3(random) * 0.2f;
+            box = AABB(box.min + offset, box.max + offset);
+        }
+
+        bvh.Refit(boxes);
+        passed = checkCull("Bvh/Cull/RefitAll") && passed;
+
+        // Triangle soup in front of the camera, the nearest hit is the same triangle at the same distance
+        const int IMAGE_SIZE = 64;
+        Mesh mesh;
+        for (int triangle = 0; triangle < 20000; ++triangle)
+        {
+            const vec3f center(RandomFloat(random, -10, 10), RandomFloat(random, -10, 10), RandomFloat(random, -30, -5));
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                mesh.positions.push_back(center + vec3f(RandomFloat(random, -0.5f, 0.5f), RandomFloat(random, -0.5f, 0.5f), RandomFloat(random, -0.5f, 0.5f)));
+                mesh.indices.push_back((uint32_t)mesh.positions.size() - 1);
+            }
+        }
+
+        const MeshPicker picker(mesh);
+        const mat4f projection = perspective4f::FromFieldOfView(1.0f, 1.0f, 0.1f, 100.0f).ToMatrix4();
+
+        int mismatches = 0;
+        int hits = 0;
+        for (int y = 0; y < IMAGE_SIZE; ++y)
+        {
+            for (int x = 0; x < IMAGE_SIZE; ++x)
+            {
+                const Ray ray = GetRasterRay(projection, (float)x, (float)y, IMAGE_SIZE, IMAGE_SIZE);
+
+                float closest = FLT_MAX;
+                uint32_t closestTriangle = UINT32_MAX;
+                for (size_t triangle = 0; triangle < mesh.GetTriangleCount(); ++triangle)
+                {
+                    float distance, u, v;
+                    if (IntersectRayTriangle(ray, mesh.positions[mesh.indices[triangle * 3]], mesh.positions[mesh.indices[triangle * 3 + 1]],
+                        mesh.positions[mesh.indices[triangle * 3 + 2]], closest, distance, u, v))
+                    {
+                        closest = distance;
+                        closestTriangle = (uint32_t)triangle;
+                    }
+                }
+
+                PickHit hit;
+                const bool picked = picker.Pick(ray, hit);
+                hits += picked;
+
+                if (picked != (closestTriangle != UINT32_MAX) || (picked && (hit.triangle != closestTriangle || hit.distance != closest)))
+                    ++mismatches;
+            }
+        }
+
+        passed = ReportCheck("Bvh/Pick", mismatches == 0 && hits > 0,
+            std::to_string(mismatches) + " of " + std::to_string(IMAGE_SIZE * IMAGE_SIZE) + " rays differ, " + std::to_string(hits) + " hits") && passed;
+
+        return passed;
+    }
+
+    // Serial and parallel updates against multiplying every world matrix again, frames add nodes under random
+    // parents, which breaks the depth first order, and move a few nodes
+    bool VerifySceneGraph()
+    {
+        const int FRAME_COUNT = 60;
+        std::mt19937 random(BENCHMARK_SEED);
+        auto randomLocal = [&]()
+        {
+            return trsf(RandomVec3(random), mat3f::Rotation(RandomVec3(random).Normalized(), RandomFloat(random, 0, 6.28f)),
+                vec3f(RandomFloat(random, 0.5f, 2.0f), RandomFloat(random, 0.5f, 2.0f), RandomFloat(random, 0.5f, 2.0f)));
+        };
+
+        JobSystem jobs(3);
+        SceneGraph serial;
+        SceneGraph parallel;
+
+        std::vector<trsf> locals;
+        std::vector<uint32_t> parents;
+        std::vector<affine4f> worlds;
+        std::vector<bool> changed;
+
+        int mismatches = 0;
+        for (int frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            // Large subtrees early on so the parallel update splits them, then a trickle of nodes
+            const size_t firstAdded = locals.size();
+            const int addCount = frame < 10 ? 2000 : 20;
+
+            for (int i = 0; i < addCount; ++i)
+            {
+                uint32_t parent = SceneGraph::NO_PARENT;
+                if (!locals.empty() && random() % 50 != 0)
+                    parent = (frame < 5 && random() % 2) ? (uint32_t)locals.size() - 1 : (uint32_t)(random() % locals.size());
+
+                const trsf local = randomLocal();
+                const uint32_t node = serial.AddNode(local, parent);
+                mismatches += parallel.AddNode(local, parent) != node || node != locals.size();
+
+                locals.push_back(local);
+                parents.push_back(parent);
+            }
+
+            changed.assign(locals.size(), false);
+            for (size_t i = 0; i < locals.size() / 50; ++i)
+            {
+                const uint32_t node = (uint32_t)(random() % locals.size());
+
+                locals[node] = randomLocal();
+                serial.SetLocal(node, locals[node]);
+                parallel.SetLocal(node, locals[node]);
+                changed[node] = true;
+            }
+
+            serial.Update();
+            parallel.Update(jobs);
+
+            // Parents were added first, so one pass in id order sees them before their children
+            worlds.resize(locals.size());
+            for (size_t node = 0; node < locals.size(); ++node)
+            {
+                const uint32_t parent = parents[node];
+
+                worlds[node] = parent == SceneGraph::NO_PARENT ? locals[node].ToAffine() : locals[node].ToAffine() * worlds[parent];
+                changed[node] = changed[node] || node >= firstAdded || (parent != SceneGraph::NO_PARENT && changed[parent]);
+
+                for (const SceneGraph* scene : { &serial, &parallel })
+                {
+                    mismatches += scene->GetParent((uint32_t)node) != parent;
+                    mismatches += memcmp(&scene->GetWorld((uint32_t)node), &worlds[node], sizeof(affine4f)) != 0;
+                    mismatches += scene->IsWorldChanged((uint32_t)node) != changed[node];
+                }
+            }
+        }
+
+        return ReportCheck("SceneGraph/Update", mismatches == 0,
+            std::to_string(mismatches) + " differences over " + std::to_string(locals.size()) + " nodes");
+    }
+
+    // Checks the optimized paths against the plain loops they replace, returns false when one of them differs
+    bool Verify()
+    {
+        bool passed = VerifyBvh();
+        passed = VerifySceneGraph() && passed;
+
+        return passed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    std::string jsonFile;
+    std::vector<std::string> extraArguments;
+    if (!ParseBenchmarkArguments(argc, argv, options, jsonFile, &extraArguments))
+        return 1;
+
+    // --verify only runs the checks, the exit code tells whether they passed
+    bool verify = false;
+    for (const std::string& argument : extraArguments)
+    {
+        if (argument != "--verify")
+        {
+            std::cerr << "Unknown argument " << argument << std::endl
+                << "Usage: " << argv[0] << " [--samples n] [--warmup n] [--min-ms ms] [--filter name] [--json file] [--verify]" << std::endl;
+            return 1;
+        }
+
+        verify = true;
+    }
+
+    if (verify)
+        return Verify() ? 0 : 1;
+
+    BenchmarkRunner runner(options);
+    RegisterMathBenchmarks(runner);
+    RegisterClipBenchmarks(runner);
+    RegisterCullBenchmarks(runner);
+    RegisterPickBenchmarks(runner);
+    RegisterOcclusionBenchmarks(runner);
+    RegisterInstanceBenchmarks(runner);
+    RegisterSceneGraphBenchmarks(runner);
+    RegisterRasterBenchmarks(runner);
+    RegisterMsaaBenchmarks(runner);
+    RegisterTgaBenchmarks(runner);
+    RegisterKernelBenchmarks(runner);
+    RegisterShaderBenchmarks(runner);
+    RegisterBlendBenchmarks(runner);
+    RegisterFastClearBenchmarks(runner);
+
+    if (!jsonFile.empty() && !runner.WriteJson(jsonFile, "MicroBenchmark"))
+    {
+        std::cerr << "Can't write " << jsonFile << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,530 @@
+#include "Benchmark.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Triangle.h"
+#include "JobSystem.h"
+#include "TileBinner.h"
+#include "Pipeline.h"
+#include "Rasterizer.h"
+#include "Blend.h"
+#include "ClearMetadata.h"
+#include "tgaimage.h"
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR "Golden"
+#endif // GOLDEN_DIR
+
+namespace
+{
+    const float PI = 3.1415926f;
+
+    struct Scene
+    {
+        std::string name;
+        Mesh mesh;
+        BlendState blend;
+    };
+
+    struct SceneOptions
+    {
+        int width = 800;
+        int height = 600;
+        std::vector<int> threadCounts = { 1, 2, 4 };
+        std::string goldenDir = GOLDEN_DIR;
+        bool updateGolden = false;
+        int tolerance = 2;				// Largest accepted difference of a channel
+        double maxMismatch = 0.001;		// Fraction of the pixels allowed to exceed the tolerance
+    };
+
+    // Golden images are small so they stay cheap to keep in the repository
+    const int GOLDEN_WIDTH = 160;
+    const int GOLDEN_HEIGHT = 120;
+
+    // Same camera as the demo: 60 degree vertical field of view looking down -z
+    mat4f CreateSceneProjection(int width, int height)
+    {
+        float zNear = 0.03f;
+        float zFar = 1000.0f;
+        float fov = 60.0f * PI / 180.0f;
+        float aspect = (float)width / height;
+
+        return perspective4f::FromFieldOfView(fov, aspect, zNear, zFar).ToMatrix4();
+    }
+
+    vec3f PositionColor(const vec3f& position, const vec3f& center, float radius)
+    {
+        vec3f offset = (position - center) / radius;
+        return vec3f(offset.x * 0.5f + 0.5f, offset.y * 0.5f + 0.5f, offset.z * 0.5f + 0.5f);
+    }
+
+    void AddQuad(Mesh& mesh, uint32_t bottomLeft, uint32_t bottomRight, uint32_t topRight, uint32_t topLeft)
+    {
+        // Clockwise seen from the camera, the winding the rasterizer keeps
+        mesh.indices.insert(mesh.indices.end(), { bottomLeft, topLeft, topRight, bottomLeft, topRight, bottomRight });
+    }
+
+    // UV sphere, the back half is culled so it also measures the cull path
+    Scene CreateSphereScene(int stacks, int slices)
+    {
+        Scene scene;
+        scene.name = "Sphere";
+
+        const vec3f center(0.0f, 0.0f, -3.0f);
+        const float radius = 1.2f;
+
+        for (int stack = 0; stack <= stacks; ++stack)
+        {
+            float phi = PI * stack / stacks;
+            for (int slice = 0; slice <= slices; ++slice)
+            {
+                float theta = 2 * PI * slice / slices;
+                vec3f position = center + vec3f(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta)) * radius;
+
+                scene.mesh.positions.push_back(position);
+                scene.mesh.colors.push_back(PositionColor(position, center, radius));
+            }
+        }
+
+        for (int stack = 0; stack < stacks; ++stack)
+        {
+            for (int slice = 0; slice < slices; ++slice)
+            {
+                uint32_t top = stack * (slices + 1) + slice;
+                uint32_t bottom = top + slices + 1;
+                AddQuad(scene.mesh, bottom + 1, bottom, top, top + 1);
+            }
+        }
+
+        return scene;
+    }
+
+    // Screen filling grid of few-pixel triangles
+    Scene CreateGridScene(int cells)
+    {
+        Scene scene;
+        scene.name = "Grid";
+
+        const float z = -1.0f;
+        const float extent = 0.8f;
+
+        for (int y = 0; y <= cells; ++y)
+        {
+            for (int x = 0; x <= cells; ++x)
+            {
+                vec3f position(-extent + 2 * extent * x / cells, -extent + 2 * extent * y / cells, z);
+
+                scene.mesh.positions.push_back(position);
+                scene.mesh.colors.push_back(PositionColor(position, vec3f(0, 0, z), extent));
+            }
+        }
+
+        for (int y = 0; y < cells; ++y)
+        {
+            for (int x = 0; x < cells; ++x)
+            {
+                uint32_t bottomLeft = y * (cells + 1) + x;
+                uint32_t topLeft = bottomLeft + cells + 1;
+                AddQuad(scene.mesh, bottomLeft, bottomLeft + 1, topLeft + 1, topLeft);
+            }
+        }
+
+        return scene;
+    }
+
+    // Large quads drawn back to front over the same pixels
+    Scene CreateOverdrawScene(int layers)
+    {
+        Scene scene;
+        scene.name = "Overdraw";
+
+        std::mt19937 random(BENCHMARK_SEED);
+        std::uniform_real_distribution<float> jitter(-0.1f, 0.1f);
+        std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+        for (int layer = 0; layer < layers; ++layer)
+        {
+            float z = -2.0f + layer * 0.02f;
+            float cx = jitter(random);
+            float cy = jitter(random);
+            float size = 0.4f;
+
+            uint32_t first = (uint32_t)scene.mesh.positions.size();
+            scene.mesh.positions.push_back(vec3f(cx - size, cy - size, z));
+            scene.mesh.positions.push_back(vec3f(cx + size, cy - size, z));
+            scene.mesh.positions.push_back(vec3f(cx + size, cy + size, z));
+            scene.mesh.positions.push_back(vec3f(cx - size, cy + size, z));
+
+            for (int i = 0; i < 4; ++i)
+                scene.mesh.colors.push_back(vec3f(channel(random), channel(random), channel(random)));
+
+            AddQuad(scene.mesh, first, first + 1, first + 2, first + 3);
+        }
+
+        return scene;
+    }
+
+    // The overdraw quads blended at half alpha, every layer shows through the ones drawn after it
+    Scene CreateAlphaOverdrawScene(int layers)
+    {
+        Scene scene = CreateOverdrawScene(layers);
+        scene.name = "AlphaOverdraw";
+        scene.blend = BlendState(BlendMode::ALPHA, 128);
+
+        return scene;
+    }
+
+    // Fan around the view axis whose rim is behind the camera, every triangle crosses the near and w planes
+    Scene CreateNearFanScene(int segments)
+    {
+        Scene scene;
+        scene.name = "NearFan";
+
+        const float radius = 2.0f;
+
+        scene.mesh.positions.push_back(vec3f(0.0f, 0.0f, -1.0f));
+        scene.mesh.colors.push_back(vec3f(1.0f, 1.0f, 1.0f));
+
+        for (int segment = 0; segment <= segments; ++segment)
+        {
+            float angle = 2 * PI * segment / segments;
+            scene.mesh.positions.push_back(vec3f(cos(angle) * radius, sin(angle) * radius, 0.5f));
+            scene.mesh.colors.push_back(vec3f(cos(angle) * 0.5f + 0.5f, sin(angle) * 0.5f + 0.5f, (float)(segment % 2)));
+        }
+
+        for (int segment = 1; segment <= segments; ++segment)
+            scene.mesh.indices.insert(scene.mesh.indices.end(), { 0u, (uint32_t)segment + 1, (uint32_t)segment });
+
+        return scene;
+    }
+
+    // Draws one frame through the serial path, threadCount 0, or through the binned parallel path. The serial path
+    // can't blend, blended frames with threadCount 0 are binned and rasterized on the calling thread
+    class SceneRenderer
+    {
+    public:
+        SceneRenderer(int width, int height, int threadCount)
+            : width(width), height(height), threadCount(threadCount),
+            jobs(threadCount > 0 ? threadCount - 1 : 0), binner(width, height, TILE_SIZE),
+            clearMetadata(width, height, TILE_SIZE), image(width, height, TGAImage::RGB)
+        {
+        }
+
+        void Render(const Mesh& mesh, const mat4f& projection, const BlendState& blend = BlendState())
+        {
+            binned = threadCount > 0 || blend.mode != BlendMode::REPLACE;
+
+            if (!binned)
+            {
+                ClearTarget(image, width, height, TGAColor(0, 0, 0));
+
+                triangles.Clear();
+                ProcessGeometry(geometry, mesh, projection, (float)width, (float)height, triangles);
+                RasterizeTriangles(image, triangles);
+            }
+            else
+            {
+                // Fast clear, the tiles nothing is drawn into are never written
+                clearMetadata.Clear(TGAColor(0, 0, 0));
+
+                binner.Reset(jobs.GetThreadCount());
+                ProcessGeometry(jobs, geometry, mesh, projection, binner, 0, blend);
+                binner.Rasterize(jobs, image, &clearMetadata);
+            }
+        }
+
+        // The binned path encodes the tiles still cleared from the metadata
+        bool Write(const std::string& filename) const
+        {
+            if (!binned)
+                return image.write_tga_file(filename);
+
+            return WriteTgaFile(filename, image, clearMetadata);
+        }
+
+        const TGAImage& GetImage()
+        {
+            if (binned)
+                clearMetadata.Resolve(image);
+
+            return image;
+        }
+
+    private:
+        int width, height;
+        int threadCount;
+        bool binned = false;	// Path of the last Render
+        JobSystem jobs;
+        TileBinner binner;
+        ClearMetadata clearMetadata;
+        TGAImage image;
+        GeometryContext geometry;
+        TriangleBatch triangles;
+    };
+
+    // Covered pixels of a frame, the sum of the raster triangle areas after clipping and culling
+    double CountFragments(const Mesh& mesh, int width, int height)
+    {
+        GeometryContext geometry;
+        TriangleBatch triangles;
+        ProcessGeometry(geometry, mesh, CreateSceneProjection(width, height), (float)width, (float)height, triangles);
+
+        double fragments = 0.0;
+        for (size_t i = 0; i < triangles.Size(); ++i)
+            fragments += 0.5 * std::abs(vec2f::EdgeFunction(triangles.GetVertex(i, 0).GetXY(), triangles.GetVertex(i, 1).GetXY(), triangles.GetVertex(i, 2).GetXY()));
+
+        return fragments;
+    }
+
+    bool CompareImages(const TGAImage& image, const TGAImage& golden, const SceneOptions& options, std::string& error)
+    {
+        if (image.get_width() != golden.get_width() || image.get_height() != golden.get_height())
+        {
+            error = "size differs from the golden image";
+            return false;
+        }
+
+        int mismatches = 0;
+        int largestDifference = 0;
+        for (int y = 0; y < image.get_height(); ++y)
+        {
+            for (int x = 0; x < image.get_width(); ++x)
+            {
+                TGAColor a = image.get(x, y);
+                TGAColor b = golden.get(x, y);
+
+                int difference = 0;
+                for (int channel = 0; channel < 3; ++channel)
+                    difference = std::max(difference, std::abs((int)a.bgra[channel] - (int)b.bgra[channel]));
+
+                largestDifference = std::max(largestDifference, difference);
+                if (difference > options.tolerance)
+                    ++mismatches;
+            }
+        }
+
+        double mismatchFraction = (double)mismatches / (image.get_width() * image.get_height());
+        if (mismatchFraction > options.maxMismatch)
+        {
+            error = std::to_string(mismatches) + " pixels differ by more than " + std::to_string(options.tolerance)
+                + ", largest difference " + std::to_string(largestDifference);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Renders the scene at the golden size through every path and checks it against the golden image
+    bool VerifyScene(const Scene& scene, const SceneOptions& options)
+    {
+        std::string goldenFile = options.goldenDir + "/" + scene.name + ".tga";
+        mat4f projection = CreateSceneProjection(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+
+        if (options.updateGolden)
+        {
+            SceneRenderer renderer(GOLDEN_WIDTH, GOLDEN_HEIGHT, 0);
+            renderer.Render(scene.mesh, projection, scene.blend);
+
+            if (!renderer.Write(goldenFile))
+            {
+                std::cerr << "Can't write " << goldenFile << std::endl;
+                return false;
+            }
+
+            std::cout << "Updated " << goldenFile << std::endl;
+            return true;
+        }
+
+        TGAImage golden;
+        if (!golden.read_tga_file(goldenFile))
+        {
+            std::cerr << "Can't read " << goldenFile << ", run with --update-golden to create it" << std::endl;
+            return false;
+        }
+
+        // Written with the default bottom-left origin, reading it back flips the rows
+        golden.flip_vertically();
+
+        std::vector<int> threadCounts = options.threadCounts;
+        threadCounts.insert(threadCounts.begin(), 0);
+
+        bool passed = true;
+        for (int threadCount : threadCounts)
+        {
+            SceneRenderer renderer(GOLDEN_WIDTH, GOLDEN_HEIGHT, threadCount);
+            renderer.Render(scene.mesh, projection, scene.blend);
+
+            // The written file too, it doesn't come from the pixels alone
+            const std::string writtenFile = "SceneVerify.tga";
+            TGAImage written;
+            bool read = renderer.Write(writtenFile) && written.read_tga_file(writtenFile);
+            std::remove(writtenFile.c_str());
+
+            std::string error;
+            if (!read)
+            {
+                error = "can't write and read back the image";
+            }
+            else
+            {
+                written.flip_vertically();
+                if (CompareImages(written, golden, options, error))
+                    CompareImages(renderer.GetImage(), golden, options, error);
+            }
+
+            if (!error.empty())
+            {
+                std::cerr << scene.name << " with " << threadCount << " threads: " << error << std::endl;
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    bool ParseSceneArguments(const std::vector<std::string>& arguments, SceneOptions& options)
+    {
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            const std::string& argument = arguments[i];
+            const char* value = i + 1 < arguments.size() ? arguments[i + 1].c_str() : nullptr;
+
+            if (argument == "--update-golden")
+            {
+                options.updateGolden = true;
+                continue;
+            }
+
+            if (!value)
+            {
+                std::cerr << "Unknown argument " << argument << std::endl;
+                return false;
+            }
+
+            if (argument == "--width")
+                options.width = std::atoi(value);
+            else if (argument == "--height")
+                options.height = std::atoi(value);
+            else if (argument == "--golden")
+                options.goldenDir = value;
+            else if (argument == "--tolerance")
+                options.tolerance = std::atoi(value);
+            else if (argument == "--max-mismatch")
+                options.maxMismatch = std::atof(value);
+            else if (argument == "--threads")
+            {
+                // Comma separated list, 0 is the serial path which always runs
+                options.threadCounts.clear();
+                for (const char* number = value; *number; )
+                {
+                    char* end;
+                    int threadCount = (int)std::strtol(number, &end, 10);
+                    if (end == number)
+                        break;
+
+                    if (threadCount > 0)
+                        options.threadCounts.push_back(threadCount);
+
+                    number = *end == ',' ? end + 1 : end;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown argument " << argument << std::endl;
+                return false;
+            }
+
+            ++i;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Frames take milliseconds, fewer samples keep a full run short
+    BenchmarkOptions benchmarkOptions;
+    benchmarkOptions.samples = 11;
+    benchmarkOptions.warmupSamples = 2;
+    benchmarkOptions.minSampleMs = 0.0;
+
+    SceneOptions options;
+    std::string jsonFile;
+    std::vector<std::string> extraArguments;
+    if (!ParseBenchmarkArguments(argc, argv, benchmarkOptions, jsonFile, &extraArguments) || !ParseSceneArguments(extraArguments, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--samples n] [--warmup n] [--min-ms ms] [--filter name] [--json file]" << std::endl
+            << "    [--width w] [--height h] [--threads 1,2,4] [--golden dir] [--update-golden] [--tolerance t] [--max-mismatch fraction]" << std::endl;
+        return 1;
+    }
+
+    std::vector<Scene> scenes;
+    scenes.push_back(CreateSphereScene(64, 128));
+    scenes.push_back(CreateGridScene(256));
+    scenes.push_back(CreateOverdrawScene(16));
+    scenes.push_back(CreateAlphaOverdrawScene(16));
+    scenes.push_back(CreateNearFanScene(64));
+
+    bool passed = true;
+    for (const Scene& scene : scenes)
+    {
+        if (benchmarkOptions.filter.empty() || ("Scene/" + scene.name).find(benchmarkOptions.filter) != std::string::npos)
+            passed = VerifyScene(scene, options) && passed;
+    }
+
+    if (options.updateGolden)
+        return passed ? 0 : 1;
+
+    BenchmarkRunner runner(benchmarkOptions);
+    mat4f projection = CreateSceneProjection(options.width, options.height);
+
+    std::vector<int> threadCounts = options.threadCounts;
+    threadCounts.insert(threadCounts.begin(), 0);
+
+    for (const Scene& scene : scenes)
+    {
+        std::vector<BenchmarkCounter> counters = {
+            { "triangles", (double)scene.mesh.GetTriangleCount() },
+            { "pixels", CountFragments(scene.mesh, options.width, options.height) }
+        };
+
+        std::string filename = "Scene" + scene.name + ".tga";
+
+        for (int threadCount : threadCounts)
+        {
+            SceneRenderer renderer(options.width, options.height, threadCount);
+
+            std::string name = "Scene/" + scene.name + "/" + (threadCount == 0 ? std::string("serial") : "threads:" + std::to_string(threadCount));
+            runner.Run(name, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    renderer.Render(scene.mesh, projection, scene.blend);
+                    renderer.Write(filename);
+                }
+            }, counters);
+        }
+    }
+
+    if (!jsonFile.empty() && !runner.WriteJson(jsonFile, "SceneBenchmark"))
+    {
+        std::cerr << "Can't write " << jsonFile << std::endl;
+        return 1;
+    }
+
+    if (!passed)
+    {
+        std::cerr << "Golden image verification failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
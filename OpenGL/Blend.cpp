@@ -0,0 +1,76 @@
+#include "Blend.h"
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cstring>
+
+TileBuffer::TileBuffer(int maxWidth, int maxHeight)
+    : minX(0), minY(0), width(0), height(0), pixels((size_t)maxWidth * maxHeight * 4)
+{
+}
+
+void TileBuffer::Load(TGAImage& image, const ScissorRect& rect)
+{
+    minX = rect.minX;
+    minY = rect.minY;
+    width = rect.maxX - rect.minX + 1;
+    height = rect.maxY - rect.minY + 1;
+
+    if (pixels.size() < (size_t)width * height * 4)
+        pixels.resize((size_t)width * height * 4);
+
+    const int bytesPerPixel = image.get_bytespp();
+    const uint8_t* source = image.buffer();
+
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = source + ((size_t)(minY + y) * image.get_width() + minX) * bytesPerPixel;
+        uint8_t* tileRow = &pixels[(size_t)y * width * 4];
+
+        // Same channel layout TGAImage::get gives, the missing ones are opaque black
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t* pixel = tileRow + x * 4;
+            pixel[0] = pixel[1] = pixel[2] = 0;
+            pixel[3] = 255;
+
+            for (int c = 0; c < bytesPerPixel; ++c)
+                pixel[c] = row[x * bytesPerPixel + c];
+        }
+    }
+}
+
+void TileBuffer::Fill(const ScissorRect& rect, const TGAColor& color)
+{
+    minX = rect.minX;
+    minY = rect.minY;
+    width = rect.maxX - rect.minX + 1;
+    height = rect.maxY - rect.minY + 1;
+
+    if (pixels.size() < (size_t)width * height * 4)
+        pixels.resize((size_t)width * height * 4);
+
+    uint8_t pixel[4] = { 0, 0, 0, 255 };
+    for (int c = 0; c < color.bytespp; ++c)
+        pixel[c] = color.bgra[c];
+
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+        memcpy(&pixels[i * 4], pixel, 4);
+}
+
+void TileBuffer::Store(TGAImage& image) const
+{
+    const int bytesPerPixel = image.get_bytespp();
+    uint8_t* destination = image.buffer();
+
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t* row = destination + ((size_t)(minY + y) * image.get_width() + minX) * bytesPerPixel;
+        const uint8_t* tileRow = &pixels[(size_t)y * width * 4];
+
+        for (int x = 0; x < width; ++x)
+        {
+            for (int c = 0; c < bytesPerPixel; ++c)
+                row[x * bytesPerPixel + c] = tileRow[x * 4 + c];
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "tgaimage.h"
+
+struct ScissorRect;
+
+// How a fragment color is combined with the color already in the target, on 8 bit BGRA
+enum class BlendMode
+{
+	REPLACE = 0,	// dst = src
+	ALPHA,			// dst.rgb = src.rgb * a + dst.rgb * (1 - a), dst.a = a + dst.a * (1 - a)
+	ADDITIVE,		// dst.rgb = dst.rgb + src.rgb * a, dst.a = a + dst.a * (1 - a), saturated
+	PREMULTIPLIED,	// dst = src + dst * (1 - a), the source color is already multiplied by a
+	COUNT
+};
+
+// Blending of a draw, alpha scales the alpha of every fragment
+struct BlendState
+{
+	BlendMode mode = BlendMode::REPLACE;
+	uint8_t alpha = 255;
+
+	BlendState()
+	{}
+
+	BlendState(BlendMode mode, uint8_t alpha = 255)
+		: mode(mode), alpha(alpha)
+	{}
+};
+
+// x / 255 rounded to nearest for x up to 255 * 255, with shifts so it vectorizes on 16 bit lanes
+inline uint32_t Div255(uint32_t x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+// Blends one BGRA pixel, same results as the BlendSpan kernel
+inline void BlendPixel(const uint8_t* source, uint8_t* destination, BlendMode mode)
+{
+	const uint32_t a = source[3];
+	const uint32_t inverse = 255 - a;
+
+	switch (mode)
+	{
+	case BlendMode::REPLACE:
+		for (int c = 0; c < 4; ++c)
+			destination[c] = source[c];
+		break;
+
+	case BlendMode::ALPHA:
+		for (int c = 0; c < 3; ++c)
+			destination[c] = (uint8_t)Div255(source[c] * a + destination[c] * inverse);
+		destination[3] = (uint8_t)(a + Div255(destination[3] * inverse));
+		break;
+
+	case BlendMode::ADDITIVE:
+		for (int c = 0; c < 3; ++c)
+		{
+			uint32_t sum = destination[c] + Div255(source[c] * a);
+			destination[c] = (uint8_t)(sum < 255 ? sum : 255);
+		}
+		destination[3] = (uint8_t)(a + Div255(destination[3] * inverse));
+		break;
+
+	case BlendMode::PREMULTIPLIED:
+		for (int c = 0; c < 4; ++c)
+		{
+			uint32_t sum = source[c] + Div255(destination[c] * inverse);
+			destination[c] = (uint8_t)(sum < 255 ? sum : 255);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+	BGRA copy of a rectangle of an image, rendered into while the tile is hot in cache.
+	Load it once before drawing the triangles of the tile and Store it once after, blending then
+	reads and writes the tile instead of going through TGAImage for every pixel.
+*/
+class TileBuffer
+{
+public:
+	// Holds rectangles up to maxWidth x maxHeight
+	TileBuffer(int maxWidth, int maxHeight);
+
+	// Copies the rectangle of the image, images without alpha load as opaque
+	void Load(TGAImage& image, const ScissorRect& rect);
+
+	// Starts the rectangle with every pixel set to color without reading the image, channels the color
+	// doesn't have are filled the way Load fills them
+	void Fill(const ScissorRect& rect, const TGAColor& color);
+
+	// Writes the rectangle back to the image it was loaded from
+	void Store(TGAImage& image) const;
+
+	int GetMinX() const
+	{
+		return minX;
+	}
+
+	int GetMinY() const
+	{
+		return minY;
+	}
+
+	int GetWidth() const
+	{
+		return width;
+	}
+
+	int GetHeight() const
+	{
+		return height;
+	}
+
+	// BGRA of pixel (x, y) in image coordinates, the rest of the row follows
+	uint8_t* GetPixel(int x, int y)
+	{
+		return &pixels[((size_t)(y - minY) * width + (x - minX)) * 4];
+	}
+
+	void Blend(int x, int y, const TGAColor& color, BlendMode mode)
+	{
+		BlendPixel(color.bgra, GetPixel(x, y), mode);
+	}
+
+private:
+	int minX, minY;
+	int width, height;
+
+	std::vector<uint8_t> pixels;
+};
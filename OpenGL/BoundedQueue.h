@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/*
+	Fixed capacity queue between two threads.
+	Push blocks while the queue is full and Pop blocks while it is empty,
+	so a fast producer can never run more than capacity items ahead.
+*/
+template<class Type>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity)
+		: capacity(capacity), closed(false)
+	{}
+
+	void Push(Type item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+
+		if (closed)
+			return;
+
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+	}
+
+	// Returns false once the queue is closed and empty
+	bool Pop(Type& item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+
+		if (items.empty())
+			return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+
+		return true;
+	}
+
+	// Wakes up every waiting thread, items already queued can still be popped
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque<Type> items;
+	size_t capacity;
+	bool closed;
+};
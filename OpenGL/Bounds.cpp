@@ -0,0 +1,124 @@
+#include "Bounds.h"
+#include <algorithm>
+#include <cmath>
+
+BoundingSphere BoundingSphere::Transformed(const affine4f& matrix) const
+{
+    // Row i of the linear part is where axis i goes, its length the scale along that axis
+    float largestScale = 0;
+    for (int row = 0; row < 3; ++row)
+    {
+        vec3f axis(matrix.Get(row, 0), matrix.Get(row, 1), matrix.Get(row, 2));
+        largestScale = std::max(largestScale, axis.SqrMagnitude());
+    }
+
+    return BoundingSphere(matrix.TransformPoint(center), radius * std::sqrt(largestScale));
+}
+
+void AABB::Add(const vec3f& point)
+{
+    min = vec3f(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+    max = vec3f(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+}
+
+void AABB::Add(const AABB& other)
+{
+    min = vec3f(std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+    max = vec3f(std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+}
+
+AABB AABB::Transformed(const affine4f& matrix) const
+{
+    if (IsEmpty())
+        return AABB();
+
+    const vec3f center = matrix.TransformPoint(GetCenter());
+    const vec3f extents = GetExtents();
+
+    float newExtents[3];
+    for (int col = 0; col < 3; ++col)
+    {
+        newExtents[col] = std::abs(matrix.Get(0, col)) * extents.x + std::abs(matrix.Get(1, col)) * extents.y
+            + std::abs(matrix.Get(2, col)) * extents.z;
+    }
+
+    const vec3f halfSize(newExtents[0], newExtents[1], newExtents[2]);
+
+    return AABB(center - halfSize, center + halfSize);
+}
+
+AABB ComputeBounds(const std::vector<vec3f>& points)
+{
+    AABB bounds;
+    for (const vec3f& point : points)
+        bounds.Add(point);
+
+    return bounds;
+}
+
+BoundingSphere ComputeBoundingSphere(const std::vector<vec3f>& points)
+{
+    if (points.empty())
+        return BoundingSphere();
+
+    const vec3f center = ComputeBounds(points).GetCenter();
+
+    float largestDistance = 0;
+    for (const vec3f& point : points)
+        largestDistance = std::max(largestDistance, (point - center).SqrMagnitude());
+
+    return BoundingSphere(center, std::sqrt(largestDistance));
+}
+
+void BoundsBatch::Clear()
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis].clear();
+        extent[axis].clear();
+    }
+
+    radius.clear();
+}
+
+void BoundsBatch::Add(const AABB& box)
+{
+    Add(box, BoundingSphere(box.GetCenter(), box.GetExtents().Magnitude()));
+}
+
+void BoundsBatch::Add(const BoundingSphere& sphere)
+{
+    const vec3f halfSize(sphere.radius, sphere.radius, sphere.radius);
+
+    Add(AABB(sphere.center - halfSize, sphere.center + halfSize), sphere);
+}
+
+void BoundsBatch::Add(const AABB& box, const BoundingSphere& sphere)
+{
+    const vec3f boxCenter = box.GetCenter();
+    const vec3f extents = box.GetExtents();
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis].push_back(boxCenter[axis]);
+        extent[axis].push_back(extents[axis]);
+    }
+
+    radius.push_back(sphere.radius + (sphere.center - boxCenter).Magnitude());
+}
+
+BoundsArrays BoundsBatch::GetArrays() const
+{
+    BoundsArrays arrays;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        arrays.center[axis] = center[axis].data();
+        arrays.extent[axis] = extent[axis].data();
+    }
+
+    arrays.radius = radius.data();
+    arrays.count = radius.size();
+
+    return arrays;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+
+// Sphere around an object
+struct BoundingSphere
+{
+	vec3f center;
+	float radius = 0;
+
+	BoundingSphere()
+	{}
+
+	BoundingSphere(const vec3f& center, float radius)
+		: center(center), radius(radius)
+	{}
+
+	// Sphere around the transformed sphere, the radius grows by the largest scale of the matrix
+	BoundingSphere Transformed(const affine4f& matrix) const;
+};
+
+// Axis aligned box, empty until a point is added
+struct AABB
+{
+	vec3f min = vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+	vec3f max = vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	AABB()
+	{}
+
+	AABB(const vec3f& min, const vec3f& max)
+		: min(min), max(max)
+	{}
+
+	bool IsEmpty() const
+	{
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	void Add(const vec3f& point);
+
+	void Add(const AABB& other);
+
+	vec3f GetCenter() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	// Half the size on each axis
+	vec3f GetExtents() const
+	{
+		return (max - min) * 0.5f;
+	}
+
+	// 0 for an empty box, proportional to the chance a random ray hits it
+	float GetSurfaceArea() const
+	{
+		if (IsEmpty())
+			return 0;
+
+		vec3f size = max - min;
+		return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// Box around the transformed box, each new half size sums the old ones weighted by the absolute matrix terms
+	AABB Transformed(const affine4f& matrix) const;
+};
+
+AABB ComputeBounds(const std::vector<vec3f>& points);
+
+// Sphere around the box of the points, not the smallest one but stable and cheap to build
+BoundingSphere ComputeBoundingSphere(const std::vector<vec3f>& points);
+
+// Bounds of count objects as arrays, what the CullBounds kernel reads
+struct BoundsArrays
+{
+	const float* center[3];
+	const float* extent[3];
+	const float* radius;
+	size_t count;
+};
+
+/*
+	Bounds of many objects as a structure of arrays, so thousands of them are tested against the frustum in
+	loops the compiler vectorizes.
+
+	Each object has a box, as its center and half size, and a sphere around the same center. The culling test
+	uses whichever of the two is tighter for each plane, so an object can be added as either one, or as both
+	when its sphere isn't the one around its box.
+*/
+class BoundsBatch
+{
+public:
+	void Clear();
+
+	size_t Size() const
+	{
+		return radius.size();
+	}
+
+	void Add(const AABB& box);
+
+	// The box is the one around the sphere
+	void Add(const BoundingSphere& sphere);
+
+	// The sphere is moved to the center of the box, its radius grows by the distance
+	void Add(const AABB& box, const BoundingSphere& sphere);
+
+	BoundsArrays GetArrays() const;
+
+private:
+	std::vector<float> center[3];
+	std::vector<float> extent[3];
+	std::vector<float> radius;
+};
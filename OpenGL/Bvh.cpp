@@ -0,0 +1,343 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Cost of visiting a node relative to testing one item
+    const float TRAVERSAL_COST = 1.0f;
+
+    struct Bin
+    {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+}
+
+void Bvh::Build(const std::vector<AABB>& boxes)
+{
+    nodes.clear();
+    items.resize(boxes.size());
+    parents.clear();
+
+    if (boxes.empty())
+    {
+        itemBounds.clear();
+        itemSlots.clear();
+        itemLeaves.clear();
+        return;
+    }
+
+    std::vector<vec3f> centers(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        items[i] = (uint32_t)i;
+        centers[i] = boxes[i].GetCenter();
+    }
+
+    // A binary tree with leaves of at least one item has fewer than twice as many nodes as items
+    nodes.reserve(boxes.size() * 2);
+    parents.reserve(boxes.size() * 2);
+
+    nodes.push_back({ AABB(), 0, (uint32_t)boxes.size(), 0 });
+    parents.push_back(0);
+
+    BuildNode(0, boxes, centers, 0);
+
+    itemBounds.resize(items.size());
+    itemSlots.resize(items.size());
+    itemLeaves.resize(items.size());
+
+    for (uint32_t index = 0; index < (uint32_t)nodes.size(); ++index)
+    {
+        const Node& node = nodes[index];
+        if (node.secondChild != 0)
+            continue;
+
+        for (uint32_t slot = node.firstItem; slot < node.firstItem + node.itemCount; ++slot)
+        {
+            itemBounds[slot] = boxes[items[slot]];
+            itemSlots[items[slot]] = slot;
+            itemLeaves[items[slot]] = index;
+        }
+    }
+}
+
+void Bvh::BuildNode(uint32_t index, const std::vector<AABB>& boxes, const std::vector<vec3f>& centers, int depth)
+{
+    const uint32_t firstItem = nodes[index].firstItem;
+    const uint32_t itemCount = nodes[index].itemCount;
+    uint32_t* const begin = items.data() + firstItem;
+    uint32_t* const end = begin + itemCount;
+
+    AABB bounds, centerBounds;
+    for (uint32_t* item = begin; item != end; ++item)
+    {
+        bounds.Add(boxes[*item]);
+        centerBounds.Add(centers[*item]);
+    }
+
+    nodes[index].bounds = bounds;
+
+    if (itemCount <= MAX_LEAF_ITEMS || depth >= MAX_DEPTH)
+        return;
+
+    // Cost of the split relative to testing every item of the node
+    const float parentArea = bounds.GetSurfaceArea();
+    float bestCost = (float)itemCount;
+    int bestAxis = -1;
+    int bestSplit = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float minCenter = centerBounds.min[axis];
+        const float extent = centerBounds.max[axis] - minCenter;
+        if (extent <= 0)
+            continue;
+
+        const float binScale = BIN_COUNT / extent;
+
+        Bin bins[BIN_COUNT];
+        for (uint32_t* item = begin; item != end; ++item)
+        {
+            int bin = std::min(BIN_COUNT - 1, (int)((centers[*item][axis] - minCenter) * binScale));
+
+            bins[bin].bounds.Add(boxes[*item]);
+            ++bins[bin].count;
+        }
+
+        // Area times count of everything right of each split, swept from the right
+        float rightCosts[BIN_COUNT];
+        AABB rightBounds;
+        uint32_t rightCount = 0;
+
+        for (int split = BIN_COUNT - 1; split > 0; --split)
+        {
+            rightBounds.Add(bins[split].bounds);
+            rightCount += bins[split].count;
+            rightCosts[split] = rightBounds.GetSurfaceArea() * rightCount;
+        }
+
+        AABB leftBounds;
+        uint32_t leftCount = 0;
+
+        // Split before bin split, both sides keep at least one item
+        for (int split = 1; split < BIN_COUNT; ++split)
+        {
+            leftBounds.Add(bins[split - 1].bounds);
+            leftCount += bins[split - 1].count;
+
+            if (leftCount == 0 || leftCount == itemCount)
+                continue;
+
+            float cost = TRAVERSAL_COST + (leftBounds.GetSurfaceArea() * leftCount + rightCosts[split]) / parentArea;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    uint32_t* middle;
+    if (bestAxis >= 0)
+    {
+        const float minCenter = centerBounds.min[bestAxis];
+        const float binScale = BIN_COUNT / (centerBounds.max[bestAxis] - minCenter);
+
+        // Same bin computation as the counting
+        middle = std::partition(begin, end, [&](uint32_t item)
+        {
+            return std::min(BIN_COUNT - 1, (int)((centers[item][bestAxis] - minCenter) * binScale)) < bestSplit;
+        });
+    }
+    else
+    {
+        // No split pays off by the heuristic, the leaf would still be too big: halves along the longest axis
+        const vec3f size = centerBounds.max - centerBounds.min;
+        const int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+
+        middle = begin + itemCount / 2;
+        std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b)
+        {
+            return centers[a][axis] < centers[b][axis];
+        });
+    }
+
+    const uint32_t leftCount = (uint32_t)(middle - begin);
+
+    const uint32_t firstChild = (uint32_t)nodes.size();
+    nodes.push_back({ AABB(), firstItem, leftCount, 0 });
+    parents.push_back(index);
+
+    BuildNode(firstChild, boxes, centers, depth + 1);
+
+    const uint32_t secondChild = (uint32_t)nodes.size();
+    nodes.push_back({ AABB(), firstItem + leftCount, itemCount - leftCount, 0 });
+    parents.push_back(index);
+
+    nodes[index].secondChild = secondChild;
+
+    BuildNode(secondChild, boxes, centers, depth + 1);
+}
+
+AABB Bvh::ComputeNodeBounds(uint32_t index) const
+{
+    const Node& node = nodes[index];
+
+    AABB bounds;
+    if (node.secondChild == 0)
+    {
+        for (uint32_t slot = node.firstItem; slot < node.firstItem + node.itemCount; ++slot)
+            bounds.Add(itemBounds[slot]);
+    }
+    else
+    {
+        bounds.Add(nodes[index + 1].bounds);
+        bounds.Add(nodes[node.secondChild].bounds);
+    }
+
+    return bounds;
+}
+
+void Bvh::Refit(const std::vector<AABB>& boxes)
+{
+    for (size_t slot = 0; slot < items.size(); ++slot)
+        itemBounds[slot] = boxes[items[slot]];
+
+    // Children come after their parent
+    for (size_t index = nodes.size(); index-- > 0;)
+        nodes[index].bounds = ComputeNodeBounds((uint32_t)index);
+}
+
+void Bvh::Refit(const std::vector<AABB>& boxes, const std::vector<uint32_t>& moved)
+{
+    for (uint32_t item : moved)
+        itemBounds[itemSlots[item]] = boxes[item];
+
+    for (uint32_t item : moved)
+    {
+        uint32_t index = itemLeaves[item];
+
+        // An unchanged box leaves the ones above it unchanged, a walk for an earlier item may have done the rest
+        while (true)
+        {
+            AABB bounds = ComputeNodeBounds(index);
+            if (bounds.min == nodes[index].bounds.min && bounds.max == nodes[index].bounds.max)
+                break;
+
+            nodes[index].bounds = bounds;
+            if (index == 0)
+                break;
+
+            index = parents[index];
+        }
+    }
+}
+
+size_t Bvh::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    if (nodes.empty())
+        return 0;
+
+    const size_t visibleBefore = visible.size();
+
+    // Nodes still to test with the planes their parent wasn't entirely inside of
+    struct Entry
+    {
+        uint32_t node;
+        uint32_t planeMask;
+    };
+
+    Entry stack[MAX_DEPTH + 1];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, (1u << Frustum::PLANE_COUNT) - 1 };
+
+    // Clears the bits of the planes box is entirely inside of, false when it is outside of one
+    auto classify = [&](const AABB& box, uint32_t& planeMask)
+    {
+        const vec3f center = box.GetCenter();
+        const vec3f extents = box.GetExtents();
+
+        for (int index = 0; index < Frustum::PLANE_COUNT; ++index)
+        {
+            if (!((planeMask >> index) & 1))
+                continue;
+
+            const vec4f& plane = frustum.GetPlane(index);
+            float distance = center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w;
+            float reach = extents.x * std::abs(plane.x) + extents.y * std::abs(plane.y) + extents.z * std::abs(plane.z);
+
+            if (distance + reach < 0)
+                return false;
+
+            if (distance - reach >= 0)
+                planeMask &= ~(1u << index);
+        }
+
+        return true;
+    };
+
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        const Node& node = nodes[entry.node];
+
+        if (!classify(node.bounds, entry.planeMask))
+            continue;
+
+        // Inside every plane, so is every item below
+        if (entry.planeMask == 0)
+        {
+            visible.insert(visible.end(), items.begin() + node.firstItem, items.begin() + node.firstItem + node.itemCount);
+            continue;
+        }
+
+        if (node.secondChild == 0)
+        {
+            for (uint32_t slot = node.firstItem; slot < node.firstItem + node.itemCount; ++slot)
+            {
+                uint32_t planeMask = entry.planeMask;
+                if (classify(itemBounds[slot], planeMask))
+                    visible.push_back(items[slot]);
+            }
+
+            continue;
+        }
+
+        // The first child is visited first to keep the tree order
+        stack[stackSize++] = { node.secondChild, entry.planeMask };
+        stack[stackSize++] = { entry.node + 1, entry.planeMask };
+    }
+
+    return visible.size() - visibleBefore;
+}
+
+bool IntersectRayBox(const Ray& ray, const vec3f& inverseDirection, const AABB& box, float maxDistance, float& distance)
+{
+    float enter = 0;
+    float exit = maxDistance;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        // Parallel to the slab, or so close that 1 / direction overflowed: inside it or never. The slab distances
+        // would be 0 * infinity for an origin on one of its planes
+        if (std::isinf(inverseDirection[axis]))
+        {
+            if (ray.origin[axis] < box.min[axis] || ray.origin[axis] > box.max[axis])
+                return false;
+
+            continue;
+        }
+
+        float t0 = (box.min[axis] - ray.origin[axis]) * inverseDirection[axis];
+        float t1 = (box.max[axis] - ray.origin[axis]) * inverseDirection[axis];
+
+        enter = std::max(enter, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    }
+
+    distance = enter;
+    return enter <= exit;
+}
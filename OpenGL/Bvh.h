@@ -0,0 +1,184 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "Bounds.h"
+#include "Frustum.h"
+
+struct Ray
+{
+	vec3f origin;
+	vec3f direction;
+
+	Ray()
+	{}
+
+	Ray(const vec3f& origin, const vec3f& direction)
+		: origin(origin), direction(direction)
+	{}
+
+	vec3f GetPoint(float distance) const
+	{
+		return origin + direction * distance;
+	}
+};
+
+/*
+	Bounding volume hierarchy over a list of boxes, scene objects or the triangles of a mesh.
+
+	The nodes are one array in depth first order: the first child of a node is the next node and the second
+	one is stored in the node, so a traversal walks mostly forward through memory. A node covers a contiguous
+	range of the reordered items, a subtree entirely inside the frustum is accepted without visiting it.
+
+	Build splits where the surface area heuristic is lowest among BIN_COUNT bins of the item centers on each
+	axis. Refit keeps the tree and only recomputes the boxes, which stays fast as long as the objects don't
+	move far from where they were at the last Build.
+*/
+class Bvh
+{
+public:
+	struct Node
+	{
+		AABB bounds;
+		uint32_t firstItem;			// Range of GetItems covered by the node
+		uint32_t itemCount;
+		uint32_t secondChild;		// 0 for leaves, the root is never a child
+	};
+
+	// Bins per axis the split candidates are counted in
+	static const int BIN_COUNT = 12;
+
+	// Leaves hold at most this many items, unless the tree gets MAX_DEPTH deep
+	static const uint32_t MAX_LEAF_ITEMS = 4;
+
+	static const int MAX_DEPTH = 48;
+
+	void Build(const std::vector<AABB>& boxes);
+
+	// New boxes for the same items, every node box is recomputed
+	void Refit(const std::vector<AABB>& boxes);
+
+	// Only the items in moved changed, the leaves holding them and their ancestors are updated
+	void Refit(const std::vector<AABB>& boxes, const std::vector<uint32_t>& moved);
+
+	// Appends the items not outside of frustum to visible, in tree order. Returns how many
+	size_t Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+	/*
+		Closest item the ray hits before maxDistance. intersect(item, ray, maxDistance) tests the item itself and
+		returns true and lowers maxDistance to the hit when it is closer. Returns the item, or UINT32_MAX with
+		maxDistance unchanged when nothing is hit.
+	*/
+	template <class Intersect>
+	uint32_t Raycast(const Ray& ray, float& maxDistance, Intersect&& intersect) const;
+
+	bool Empty() const
+	{
+		return nodes.empty();
+	}
+
+	const std::vector<Node>& GetNodes() const
+	{
+		return nodes;
+	}
+
+	// Item indices in leaf order
+	const std::vector<uint32_t>& GetItems() const
+	{
+		return items;
+	}
+
+private:
+	// Makes node index a leaf or splits its items, the children are appended after it
+	void BuildNode(uint32_t index, const std::vector<AABB>& boxes, const std::vector<vec3f>& centers, int depth);
+
+	// Bounds of node index from its items or its children
+	AABB ComputeNodeBounds(uint32_t index) const;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> items;
+	std::vector<AABB> itemBounds;		// In leaf order, next to each other for the leaf tests
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> itemSlots;	// Position of every item in items, by item index
+	std::vector<uint32_t> itemLeaves;	// Leaf of every item, by item index
+};
+
+// Distance along the ray where it enters box, from the precomputed 1 / direction. Returns false when it misses
+// the box or only meets it past maxDistance
+bool IntersectRayBox(const Ray& ray, const vec3f& inverseDirection, const AABB& box, float maxDistance, float& distance);
+
+template <class Intersect>
+uint32_t Bvh::Raycast(const Ray& ray, float& maxDistance, Intersect&& intersect) const
+{
+	uint32_t hit = UINT32_MAX;
+	if (nodes.empty())
+		return hit;
+
+	const vec3f inverseDirection(1 / ray.direction.x, 1 / ray.direction.y, 1 / ray.direction.z);
+
+	float distance;
+	if (!IntersectRayBox(ray, inverseDirection, nodes[0].bounds, maxDistance, distance))
+		return hit;
+
+	// Nodes still to visit with the distance their box was entered at
+	struct Entry
+	{
+		uint32_t node;
+		float distance;
+	};
+
+	Entry stack[MAX_DEPTH + 1];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, distance };
+
+	while (stackSize > 0)
+	{
+		const Entry entry = stack[--stackSize];
+
+		// A closer hit was found since it was pushed
+		if (entry.distance > maxDistance)
+			continue;
+
+		const Node& node = nodes[entry.node];
+
+		if (node.secondChild == 0)
+		{
+			for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i)
+			{
+				if (intersect(items[i], ray, maxDistance))
+					hit = items[i];
+			}
+
+			continue;
+		}
+
+		float firstDistance, secondDistance;
+		bool first = IntersectRayBox(ray, inverseDirection, nodes[entry.node + 1].bounds, maxDistance, firstDistance);
+		bool second = IntersectRayBox(ray, inverseDirection, nodes[node.secondChild].bounds, maxDistance, secondDistance);
+
+		// The nearer child is pushed last so it is visited first
+		if (first && second)
+		{
+			if (firstDistance < secondDistance)
+			{
+				stack[stackSize++] = { node.secondChild, secondDistance };
+				stack[stackSize++] = { entry.node + 1, firstDistance };
+			}
+			else
+			{
+				stack[stackSize++] = { entry.node + 1, firstDistance };
+				stack[stackSize++] = { node.secondChild, secondDistance };
+			}
+		}
+		else if (first)
+		{
+			stack[stackSize++] = { entry.node + 1, firstDistance };
+		}
+		else if (second)
+		{
+			stack[stackSize++] = { node.secondChild, secondDistance };
+		}
+	}
+
+	return hit;
+}
@@ -0,0 +1,175 @@
+#include "ClearMetadata.h"
+#include "Rasterizer.h"
+#include "Kernels.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+ClearMetadata::ClearMetadata(int width, int height, int tileSize)
+    : width(width), height(height), tileSize(tileSize)
+{
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+
+    // Nothing is known about the pixels yet
+    cleared.assign(GetTileCount(), 0);
+}
+
+void ClearMetadata::Clear(const TGAColor& color)
+{
+    clearColor = color;
+    std::fill(cleared.begin(), cleared.end(), (uint8_t)1);
+}
+
+void ClearMetadata::Resolve(TGAImage& image)
+{
+    PROFILE_SCOPE("resolve clear");
+
+    const int bytesPerPixel = image.get_bytespp();
+    uint8_t* pixels = image.buffer();
+
+    for (int tile = 0; tile < GetTileCount(); ++tile)
+    {
+        if (!cleared[tile])
+            continue;
+
+        ScissorRect rect = GetTileRect(tile);
+
+        for (int y = rect.minY; y <= rect.maxY; ++y)
+        {
+            uint8_t* row = pixels + ((size_t)y * width + rect.minX) * bytesPerPixel;
+            for (int x = 0; x <= rect.maxX - rect.minX; ++x)
+                memcpy(row + x * bytesPerPixel, clearColor.bgra, bytesPerPixel);
+        }
+
+        cleared[tile] = 0;
+    }
+}
+
+ScissorRect ClearMetadata::GetTileRect(int tile) const
+{
+    ScissorRect rect;
+    rect.minX = (tile % tilesX) * tileSize;
+    rect.minY = (tile / tilesX) * tileSize;
+    rect.maxX = std::min(rect.minX + tileSize, width) - 1;
+    rect.maxY = std::min(rect.minY + tileSize, height) - 1;
+
+    return rect;
+}
+
+size_t ClearMetadata::GetClearedTileCount() const
+{
+    return (size_t)std::count(cleared.begin(), cleared.end(), (uint8_t)1);
+}
+
+bool WriteTgaFile(const std::string& filename, const TGAImage& image, const ClearMetadata& metadata, bool vflip)
+{
+    PROFILE_SCOPE("write tga");
+
+    const int width = image.get_width();
+    const int height = image.get_height();
+    const int bytesPerPixel = image.get_bytespp();
+    const int tileSize = metadata.GetTileSize();
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const size_t pixelCount = (size_t)width * height;
+
+    const uint8_t* pixels = image.buffer();
+    const uint8_t* clearColor = metadata.GetClearColor().bgra;
+
+    std::vector<uint8_t> scratch(pixelCount * bytesPerPixel);
+    std::vector<uint8_t> encoded(pixelCount * (bytesPerPixel + 1));
+    size_t written = 0;
+
+    const Kernels& kernels = GetKernels();
+
+    // Cleared pixels waiting to be written as runs, and the range of pixels to encode from memory
+    size_t pendingClear = 0;
+    size_t dataStart = 0;
+    size_t dataLength = 0;
+
+    auto flushClear = [&]()
+    {
+        const size_t MAX_CHUNK_LENGTH = 128;
+
+        while (pendingClear > 0)
+        {
+            size_t runLength = std::min(pendingClear, MAX_CHUNK_LENGTH);
+            encoded[written++] = (uint8_t)(runLength + 127);
+            memcpy(&encoded[written], clearColor, bytesPerPixel);
+            written += bytesPerPixel;
+            pendingClear -= runLength;
+        }
+    };
+
+    auto flushData = [&]()
+    {
+        if (dataLength == 0)
+            return;
+
+        written += kernels.EncodeRle(pixels + dataStart * bytesPerPixel, dataLength, bytesPerPixel, scratch.data(), &encoded[written]);
+        dataLength = 0;
+    };
+
+    // Rows in memory order, each row crosses a row of tiles
+    for (int y = 0; y < height; ++y)
+    {
+        const int tileRow = (y / tileSize) * tilesX;
+
+        for (int tileX = 0; tileX < tilesX; ++tileX)
+        {
+            const int minX = tileX * tileSize;
+            const size_t length = (size_t)(std::min(minX + tileSize, width) - minX);
+
+            if (metadata.IsCleared(tileRow + tileX))
+            {
+                flushData();
+                pendingClear += length;
+            }
+            else
+            {
+                flushClear();
+                if (dataLength == 0)
+                    dataStart = (size_t)y * width + minX;
+
+                dataLength += length;
+            }
+        }
+    }
+
+    flushData();
+    flushClear();
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+    {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+
+    TGA_Header header;
+    header.bitsperpixel = bytesPerPixel << 3;
+    header.width = width;
+    header.height = height;
+    header.datatypecode = bytesPerPixel == TGAImage::GRAYSCALE ? 11 : 10;
+    header.imagedescriptor = vflip ? 0x00 : 0x20;
+
+    const uint8_t developerAreaRef[4] = { 0, 0, 0, 0 };
+    const uint8_t extensionAreaRef[4] = { 0, 0, 0, 0 };
+    const char footer[18] = { 'T','R','U','E','V','I','S','I','O','N','-','X','F','I','L','E','.','\0' };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(encoded.data()), written);
+    out.write(reinterpret_cast<const char*>(developerAreaRef), sizeof(developerAreaRef));
+    out.write(reinterpret_cast<const char*>(extensionAreaRef), sizeof(extensionAreaRef));
+    out.write(footer, sizeof(footer));
+
+    if (!out.good())
+    {
+        std::cerr << "can't dump the tga file\n";
+        return false;
+    }
+
+    return true;
+}
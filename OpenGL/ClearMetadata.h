@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tgaimage.h"
+
+struct ScissorRect;
+
+/*
+	Fast clear state of the tiles of an image.
+
+	Clear only marks every tile as cleared to a color, the pixels are not touched. A cleared tile is
+	filled when something is first drawn into it, and the TGA writer emits runs of the clear color for
+	the tiles still cleared without reading their pixels. Frames where most of the image stays
+	background then skip most of the clear and encode work.
+
+	Anything reading the pixels of the image directly has to Resolve first.
+*/
+class ClearMetadata
+{
+public:
+	ClearMetadata(int width, int height, int tileSize);
+
+	// Marks every tile as cleared to color, no pixel is written
+	void Clear(const TGAColor& color);
+
+	// Writes the clear color into the tiles still cleared, the image is complete afterwards
+	void Resolve(TGAImage& image);
+
+	// Called once the pixels of the tile hold valid colors
+	void MarkWritten(int tile)
+	{
+		cleared[tile] = 0;
+	}
+
+	bool IsCleared(int tile) const
+	{
+		return cleared[tile] != 0;
+	}
+
+	const TGAColor& GetClearColor() const
+	{
+		return clearColor;
+	}
+
+	int GetTileSize() const
+	{
+		return tileSize;
+	}
+
+	int GetTileCount() const
+	{
+		return tilesX * tilesY;
+	}
+
+	ScissorRect GetTileRect(int tile) const;
+
+	size_t GetClearedTileCount() const;
+
+private:
+	int width, height;
+	int tileSize;
+	int tilesX, tilesY;
+
+	TGAColor clearColor;
+	std::vector<uint8_t> cleared;	// 1 for tiles whose pixels are the clear color but were not written
+};
+
+// RLE TGA file of the image, same format as TGAImage::write_tga_file. The tiles still cleared are written as runs
+// of the clear color straight from the metadata, the rest is encoded from the pixels
+bool WriteTgaFile(const std::string& filename, const TGAImage& image, const ClearMetadata& metadata, bool vflip = true);
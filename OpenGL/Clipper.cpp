@@ -0,0 +1,217 @@
+#include "Clipper.h"
+#include "Profiler.h"
+#include <algorithm>
+
+int ClipAgainstPlane(const Triangle& triangle, Plane plane, Triangle* parts)
+{
+    bool isV0Inside = IsInsidePlane(plane, triangle.vertices[0]);
+    bool isV1Inside = IsInsidePlane(plane, triangle.vertices[1]);
+    bool isV2Inside = IsInsidePlane(plane, triangle.vertices[2]);
+
+    if (isV0Inside && isV1Inside && isV2Inside)
+    {
+        parts[0] = triangle;
+        return 1;
+    }
+
+    else if (!isV0Inside && !isV1Inside && !isV2Inside)
+    {
+        return 0;
+    }
+
+    else
+    {
+        PROFILE_COUNT((Counter)((int)Counter::CLIP_POSITIVEW + (int)plane), 1);
+
+        // A triangle clipped by one plane has at most 4 vertices
+        vec4f vertices[4];
+        vec3f colors[4];
+        int vertexCount = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            vec4f prev = triangle.vertices[(i + 2) % 3];
+            vec4f curr = triangle.vertices[i];
+
+            vec3f prevC = triangle.colors[(i + 2) % 3];
+            vec3f currC = triangle.colors[i];
+
+            bool isPrevInside = IsInsidePlane(plane, prev);
+            bool isCurrInside = IsInsidePlane(plane, curr);
+
+            if (isPrevInside != isCurrInside)
+            {
+                float ratio = GetIntersectionRatio(plane, curr, prev);
+
+                vec4f point = Lerp(prev, curr, ratio);
+                vec3f color = Lerp(prevC, currC, ratio);
+
+                vertices[vertexCount] = point;
+                colors[vertexCount] = color;
+                ++vertexCount;
+            }
+
+            if (isCurrInside)
+            {
+                vertices[vertexCount] = curr;
+                colors[vertexCount] = currC;
+                ++vertexCount;
+            }
+        }
+
+        for (int i = 0; i < vertexCount - 2; ++i)
+        {
+            parts[i] = Triangle(vertices[0], vertices[i + 1], vertices[i + 2], colors[0], colors[i+1], colors[i+2]);
+        }
+
+        return vertexCount - 2;
+    }
+
+}
+
+void ClipAgainstPlane(const Triangle& triangle, TriangleList& outlist, Plane plane)
+{
+    Triangle parts[2];
+    int partCount = ClipAgainstPlane(triangle, plane, parts);
+
+    outlist.insert(outlist.end(), parts, parts + partCount);
+}
+
+
+void ClipTriangle(const Triangle& triangle, TriangleList& outList)
+{
+    // Check if Entire triangle is inside View Frustum, with the planes of PLANE_COEFFICIENTS like BatchClipper
+    if (IsInsideFrustum(triangle.vertices[0]) && IsInsideFrustum(triangle.vertices[1]) && IsInsideFrustum(triangle.vertices[2]))
+    {
+        outList.push_back(triangle);
+
+        return;
+    }
+
+    PROFILE_COUNT(Counter::TRIANGLES_CLIPPED, 1);
+
+    // Two lists to swap the triangles between the planes, kept apart from outList
+    // so the triangles already in it are not clipped again
+    TriangleList inTriList(outList.get_allocator());
+    TriangleList clippedList(outList.get_allocator());
+
+    inTriList.push_back(triangle);
+
+
+    auto loopOver = [](TriangleList& inList, TriangleList& outList, Plane plane)
+    {
+        while (inList.size() > 0)
+        {
+            ClipAgainstPlane(inList.front(), outList, plane);
+
+            inList.pop_front(); //
+        }
+    };
+
+    loopOver(inTriList, clippedList, Plane::POSITIVEW);
+    loopOver(clippedList, inTriList, Plane::RIGHT);
+    loopOver(inTriList, clippedList, Plane::LEFT);
+    loopOver(clippedList, inTriList, Plane::TOP);
+    loopOver(inTriList, clippedList, Plane::BOTTOM);
+    loopOver(clippedList, inTriList, Plane::NEAR);
+    loopOver(inTriList, clippedList, Plane::FAR);
+
+    outList.splice(outList.end(), clippedList);
+}
+
+namespace
+{
+    // Plane order of ClipTriangle
+    const Plane CLIP_ORDER[] = { Plane::POSITIVEW, Plane::RIGHT, Plane::LEFT, Plane::TOP, Plane::BOTTOM, Plane::NEAR, Plane::FAR };
+
+    const int PLANE_COUNT = (int)Plane::NEAR + 1;
+
+    // Bit 0 of every plane in an outside mask, a plane every vertex is outside of leaves one set after ANDing the slots
+    const uint32_t FIRST_SLOT_BITS = 0x49249;
+
+    uint32_t GetOutsideVertices(uint32_t outside, Plane plane)
+    {
+        return (outside >> ((int)plane * 3)) & 7;
+    }
+}
+
+void BatchClipper::ClipCrossing(const Triangle& triangle, uint32_t outsideMask, uint32_t id, TriangleBatch& out)
+{
+    std::vector<Triangle>* current = &parts[0];
+    std::vector<Triangle>* next = &parts[1];
+
+    current->assign(1, triangle);
+
+    for (Plane plane : CLIP_ORDER)
+    {
+        // Every vertex inside, and so every piece too
+        if (GetOutsideVertices(outsideMask, plane) == 0)
+            continue;
+
+        next->clear();
+
+        for (const Triangle& piece : *current)
+        {
+            Triangle planeParts[2];
+            int partCount = ClipAgainstPlane(piece, plane, planeParts);
+
+            next->insert(next->end(), planeParts, planeParts + partCount);
+        }
+
+        std::swap(current, next);
+    }
+
+    for (const Triangle& piece : *current)
+        out.Add(piece, id);
+}
+
+void BatchClipper::Clip(const TriangleBatch& triangles, TriangleBatch& out)
+{
+    const size_t count = triangles.Size();
+
+    outside.assign(count, 0);
+
+    // Bit plane * 3 + slot is set when vertex slot is outside of plane
+    for (int plane = 0; plane < PLANE_COUNT; ++plane)
+    {
+        const PlaneCoefficients& coefficients = PLANE_COEFFICIENTS[plane];
+
+        for (int slot = 0; slot < 3; ++slot)
+        {
+            const float* x = triangles.Get(TriangleBatch::X, slot);
+            const float* y = triangles.Get(TriangleBatch::Y, slot);
+            const float* z = triangles.Get(TriangleBatch::Z, slot);
+            const float* w = triangles.Get(TriangleBatch::W, slot);
+
+            const int bit = plane * 3 + slot;
+
+            for (size_t i = 0; i < count; ++i)
+                outside[i] |= (uint32_t)!(GetPlaneDot(coefficients, x[i], y[i], z[i], w[i]) + coefficients.offset >= 0) << bit;
+        }
+    }
+
+    const uint32_t* ids = triangles.GetIds();
+
+    // Start of the triangles inside not copied yet, consecutive ones are copied together
+    size_t insideStart = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t outsideMask = outside[i];
+        if (outsideMask == 0)
+            continue;
+
+        out.Append(triangles, insideStart, i);
+        insideStart = i + 1;
+
+        PROFILE_COUNT(Counter::TRIANGLES_CLIPPED, 1);
+
+        // Dropped when all three vertices are outside of the same plane
+        const bool rejected = (outsideMask & (outsideMask >> 1) & (outsideMask >> 2) & FIRST_SLOT_BITS) != 0;
+
+        if (!rejected)
+            ClipCrossing(triangles.GetTriangle(i), outsideMask, ids[i], out);
+    }
+
+    out.Append(triangles, insideStart, count);
+}
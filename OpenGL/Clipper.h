@@ -0,0 +1,43 @@
+#pragma once
+#include <list>
+#include <vector>
+#include "Triangle.h"
+#include "TriangleBatch.h"
+#include "MathCommon.h"
+#include "FrameArena.h"
+
+// Triangle list that can live in a frame arena, default constructed it uses the heap
+typedef std::list<Triangle, ArenaAllocator<Triangle>> TriangleList;
+
+// Writes the parts of triangle inside the plane to parts, at most 2. Returns how many
+int ClipAgainstPlane(const Triangle& triangle, Plane plane, Triangle* parts);
+
+// Appends the parts of triangle inside the plane to outlist
+void ClipAgainstPlane(const Triangle& triangle, TriangleList& outlist, Plane plane);
+
+// Appends the parts of triangle inside the view frustum to outList, the temporary lists use the allocator of outList
+void ClipTriangle(const Triangle& triangle, TriangleList& outList);
+
+/*
+	Clips batches of triangles against the view frustum.
+
+	The sides of every vertex of the batch come first, from PLANE_COEFFICIENTS with the same loop for every plane,
+	and end up in a mask per triangle. Triangles inside every plane are copied a run at a time and triangles
+	entirely outside of one are dropped, only the few crossing a plane go through the per triangle clipper, and
+	only against the planes they cross. The pieces are the ones of ClipTriangle, in the same order.
+
+	The scratch buffers are kept between calls, GeometryContext holds one clipper per geometry thread.
+*/
+class BatchClipper
+{
+public:
+	// Appends the parts of the triangles inside the view frustum to out in order, every piece keeps the id of its triangle
+	void Clip(const TriangleBatch& triangles, TriangleBatch& out);
+
+private:
+	// Clips triangle against the planes it has a vertex outside of, in the order of ClipTriangle. The pieces are added to out
+	void ClipCrossing(const Triangle& triangle, uint32_t outsideMask, uint32_t id, TriangleBatch& out);
+
+	std::vector<uint32_t> outside;		// Vertices outside of each plane, 3 bits per plane
+	std::vector<Triangle> parts[2];		// Pieces before and after a plane
+};
@@ -0,0 +1,85 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdlib>
+
+LinearArena::LinearArena(size_t blockSize)
+    : first(nullptr), current(nullptr), offset(0), usedBeforeCurrent(0), highWaterMark(0), capacity(0), blockSize(blockSize)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    Block* block = first;
+    while (block)
+    {
+        Block* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    while (true)
+    {
+        if (current)
+        {
+            // Align the address, not the offset, the block data is only aligned to the header
+            uintptr_t base = reinterpret_cast<uintptr_t>(current->Data());
+            uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            size_t end = (size_t)(aligned - base) + size;
+
+            if (end <= current->size)
+            {
+                offset = end;
+                highWaterMark = std::max(highWaterMark, GetUsed());
+                return reinterpret_cast<void*>(aligned);
+            }
+
+            // Blocks kept from the previous frames are reused before asking for more memory
+            if (current->next && current->next->size >= size + alignment)
+            {
+                usedBeforeCurrent += current->size;
+                current = current->next;
+                offset = 0;
+                continue;
+            }
+        }
+
+        // New block after the current one, big enough for oversized requests
+        size_t dataSize = std::max(blockSize, size + alignment);
+        Block* block = static_cast<Block*>(malloc(sizeof(Block) + dataSize));
+        if (!block)
+            throw std::bad_alloc();
+
+        block->size = dataSize;
+        capacity += dataSize;
+
+        if (current)
+        {
+            block->next = current->next;
+            current->next = block;
+            usedBeforeCurrent += current->size;
+        }
+        else
+        {
+            block->next = first;
+            first = block;
+        }
+
+        current = block;
+        offset = 0;
+    }
+}
+
+void LinearArena::Reset()
+{
+    current = first;
+    offset = 0;
+    usedBeforeCurrent = 0;
+}
+
+FrameArena::FrameArena(size_t blockSize)
+    : arena(blockSize)
+{
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/*
+	Bump allocator for memory that only lives for one frame.
+
+	Memory is taken from a chain of blocks and never given back one allocation at
+	a time, Reset rewinds to the first block in O(1) and keeps the blocks for the
+	next frame. Not thread safe, give every thread its own arena.
+*/
+class LinearArena
+{
+public:
+	explicit LinearArena(size_t blockSize = 64 * 1024);
+	~LinearArena();
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator = (const LinearArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<class T>
+	T* Allocate(size_t count)
+	{
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// Releases everything allocated since the last reset
+	void Reset();
+
+	// Bytes handed out since the last reset, including alignment padding and the unused end of full blocks
+	size_t GetUsed() const
+	{
+		return usedBeforeCurrent + offset;
+	}
+
+	// Largest GetUsed seen since the arena was created
+	size_t GetHighWaterMark() const
+	{
+		return highWaterMark;
+	}
+
+	// Bytes reserved from the system
+	size_t GetCapacity() const
+	{
+		return capacity;
+	}
+
+private:
+	struct Block
+	{
+		Block* next;
+		size_t size;
+
+		uint8_t* Data()
+		{
+			return reinterpret_cast<uint8_t*>(this + 1);
+		}
+	};
+
+	Block* first;
+	Block* current;
+	size_t offset;
+	size_t usedBeforeCurrent;
+	size_t highWaterMark;
+	size_t capacity;
+	size_t blockSize;
+};
+
+/*
+	Standard allocator on top of a LinearArena so std containers can live in the frame memory.
+	deallocate does nothing, the memory comes back when the arena is reset.
+	Without an arena it falls back to the global new and delete.
+*/
+template<class T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator()
+		: arena(nullptr)
+	{}
+
+	ArenaAllocator(LinearArena* arena)
+		: arena(arena)
+	{}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other)
+		: arena(other.GetArena())
+	{}
+
+	T* allocate(size_t count)
+	{
+		if (arena)
+			return arena->Allocate<T>(count);
+
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T* pointer, size_t)
+	{
+		if (!arena)
+			::operator delete(pointer);
+	}
+
+	LinearArena* GetArena() const
+	{
+		return arena;
+	}
+
+	template<class U>
+	bool operator == (const ArenaAllocator<U>& other) const
+	{
+		return arena == other.GetArena();
+	}
+
+	template<class U>
+	bool operator != (const ArenaAllocator<U>& other) const
+	{
+		return arena != other.GetArena();
+	}
+
+private:
+	LinearArena* arena;
+};
+
+/*
+	The transient memory of a frame on the main thread. The geometry threads don't allocate from it, their scratch
+	is kept from frame to frame in a GeometryContext.
+*/
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t blockSize = 256 * 1024);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator = (const FrameArena&) = delete;
+
+	LinearArena& Get()
+	{
+		return arena;
+	}
+
+	// Called at the end of the frame, nothing allocated from the arena may be used afterwards
+	void Reset()
+	{
+		arena.Reset();
+	}
+
+	// Bytes used during the current frame
+	size_t GetUsed() const
+	{
+		return arena.GetUsed();
+	}
+
+	// Most bytes used by a single frame so far
+	size_t GetHighWaterMark() const
+	{
+		return arena.GetHighWaterMark();
+	}
+
+	size_t GetCapacity() const
+	{
+		return arena.GetCapacity();
+	}
+
+private:
+	LinearArena arena;
+};
@@ -0,0 +1,147 @@
+#include "FramePipeline.h"
+#include "BoundedQueue.h"
+#include "Pipeline.h"
+#include "Rasterizer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    typedef chrono::steady_clock Clock;
+
+    struct GeometryPacket
+    {
+        int frame;
+        TriangleBatch triangles;
+    };
+
+    struct FramePacket
+    {
+        int frame;
+        int framebuffer;
+    };
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return chrono::duration<double, milli>(Clock::now() - start).count();
+    }
+
+    void AddTiming(FramePipeline::StageTiming& timing, double ms)
+    {
+        timing.totalMs += ms;
+        timing.maxMs = max(timing.maxMs, ms);
+        ++timing.frames;
+    }
+}
+
+FramePipeline::FramePipeline(int width, int height, const TGAColor& clearColor, size_t queueDepth)
+    : width(width), height(height), clearColor(clearColor), queueDepth(max<size_t>(1, queueDepth)), totalMs(0)
+{
+    framebuffers[0] = TGAImage(width, height, TGAImage::RGB);
+    framebuffers[1] = TGAImage(width, height, TGAImage::RGB);
+}
+
+void FramePipeline::Run(int frameCount, const GeometryFunction& geometry, const EncodeFunction& encode)
+{
+    for (StageTiming& timing : timings)
+        timing = StageTiming();
+
+    Clock::time_point runStart = Clock::now();
+
+    BoundedQueue<GeometryPacket> geometryQueue(queueDepth);
+    BoundedQueue<FramePacket> encodeQueue(1);
+    BoundedQueue<int> freeFramebuffers(2);
+
+    freeFramebuffers.Push(0);
+    freeFramebuffers.Push(1);
+
+    thread geometryThread([&]()
+    {
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            Clock::time_point start = Clock::now();
+
+            GeometryPacket packet;
+            packet.frame = frame;
+            {
+                PROFILE_SCOPE("geometry stage");
+                geometry(frame, packet.triangles);
+            }
+
+            AddTiming(timings[GEOMETRY], ElapsedMs(start));
+
+            geometryQueue.Push(move(packet));
+        }
+
+        geometryQueue.Close();
+    });
+
+    thread rasterThread([&]()
+    {
+        GeometryPacket packet;
+
+        while (geometryQueue.Pop(packet))
+        {
+            int framebuffer;
+            if (!freeFramebuffers.Pop(framebuffer))
+                break;
+
+            Clock::time_point start = Clock::now();
+
+            TGAImage& image = framebuffers[framebuffer];
+            {
+                PROFILE_SCOPE("raster stage");
+                ClearTarget(image, width, height, clearColor);
+                RasterizeTriangles(image, packet.triangles);
+            }
+
+            AddTiming(timings[RASTER], ElapsedMs(start));
+
+            encodeQueue.Push({ packet.frame, framebuffer });
+        }
+
+        encodeQueue.Close();
+    });
+
+    // The calling thread encodes
+    FramePacket packet;
+
+    while (encodeQueue.Pop(packet))
+    {
+        Clock::time_point start = Clock::now();
+
+        {
+            PROFILE_SCOPE("encode stage");
+            encode(packet.frame, framebuffers[packet.framebuffer]);
+        }
+
+        AddTiming(timings[ENCODE], ElapsedMs(start));
+
+        freeFramebuffers.Push(packet.framebuffer);
+    }
+
+    geometryThread.join();
+    rasterThread.join();
+
+    totalMs = ElapsedMs(runStart);
+}
+
+void FramePipeline::PrintTiming(ostream& os) const
+{
+    static const char* names[STAGE_COUNT] = { "geometry", "raster", "encode" };
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        const StageTiming& timing = timings[stage];
+        double average = timing.frames ? timing.totalMs / timing.frames : 0;
+
+        os << names[stage] << ": " << timing.frames << " frames, "
+            << timing.totalMs << " ms total, " << average << " ms avg, " << timing.maxMs << " ms max" << endl;
+    }
+
+    os << "wall: " << totalMs << " ms" << endl;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "TriangleBatch.h"
+#include "tgaimage.h"
+
+/*
+	Renders a sequence of frames with the three stages running at the same time:
+	the geometry of frame N + 1 is processed while frame N is rasterized and
+	frame N - 1 is written out.
+
+	The stages talk through bounded queues and the rasterizer alternates between
+	two framebuffers, a framebuffer goes back to the rasterizer once it is encoded.
+*/
+class FramePipeline
+{
+public:
+	enum Stage
+	{
+		GEOMETRY = 0,
+		RASTER,
+		ENCODE,
+		STAGE_COUNT
+	};
+
+	struct StageTiming
+	{
+		double totalMs = 0;	// Time spent working, waiting on the queues is not included
+		double maxMs = 0;	// Slowest frame
+		int frames = 0;
+	};
+
+	// Fills the raster space triangles of a frame
+	typedef std::function<void(int frame, TriangleBatch& triangles)> GeometryFunction;
+
+	// Writes out a finished frame
+	typedef std::function<void(int frame, const TGAImage& image)> EncodeFunction;
+
+	FramePipeline(int width, int height, const TGAColor& clearColor, size_t queueDepth = 2);
+
+	void Run(int frameCount, const GeometryFunction& geometry, const EncodeFunction& encode);
+
+	const StageTiming& GetTiming(Stage stage) const
+	{
+		return timings[stage];
+	}
+
+	// Wall clock time of the last Run
+	double GetTotalMs() const
+	{
+		return totalMs;
+	}
+
+	void PrintTiming(std::ostream& os) const;
+
+private:
+	int width, height;
+	TGAColor clearColor;
+	size_t queueDepth;
+
+	TGAImage framebuffers[2];
+
+	StageTiming timings[STAGE_COUNT];
+	double totalMs;
+};
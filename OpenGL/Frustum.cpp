@@ -0,0 +1,99 @@
+#include "Frustum.h"
+#include "Kernels.h"
+#include "MathCommon.h"
+#include <algorithm>
+#include <cmath>
+
+Frustum::Frustum()
+{
+    // Every point inside
+    std::fill(planes, planes + PLANE_COUNT, vec4f(0, 0, 0, 1));
+}
+
+Frustum::Frustum(const mat4f& matrix)
+{
+    const vec4f columns[4] = { matrix.GetCol(0), matrix.GetCol(1), matrix.GetCol(2), matrix.GetCol(3) };
+
+    for (int index = 0; index < PLANE_COUNT; ++index)
+    {
+        // The clip space test dot(coefficients, v * matrix) is dot(v, sum of the columns weighted by the coefficients)
+        const PlaneCoefficients& coefficients = PLANE_COEFFICIENTS[(int)Plane::RIGHT + index];
+
+        vec4f plane = columns[0] * coefficients.x + columns[1] * coefficients.y + columns[2] * coefficients.z
+            + columns[3] * coefficients.w;
+
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0)
+            plane = plane / length;
+
+        planes[index] = plane;
+    }
+}
+
+bool Frustum::IsVisible(const BoundingSphere& sphere) const
+{
+    for (const vec4f& plane : planes)
+    {
+        float distance = sphere.center.x * plane.x + sphere.center.y * plane.y + sphere.center.z * plane.z + plane.w;
+        if (distance + sphere.radius < 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool Frustum::IsVisible(const AABB& box) const
+{
+    const vec3f center = box.GetCenter();
+    const vec3f extents = box.GetExtents();
+
+    for (const vec4f& plane : planes)
+    {
+        float distance = center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w;
+        float reach = extents.x * std::abs(plane.x) + extents.y * std::abs(plane.y) + extents.z * std::abs(plane.z);
+
+        if (distance + reach < 0)
+            return false;
+    }
+
+    return true;
+}
+
+size_t CullBounds(const Frustum& frustum, const BoundsBatch& bounds, std::vector<uint32_t>& visible)
+{
+    // Objects tested per kernel call, the flags stay on the stack
+    const size_t CHUNK_SIZE = 256;
+
+    const BoundsArrays arrays = bounds.GetArrays();
+    const Kernels& kernels = GetKernels();
+
+    uint8_t flags[CHUNK_SIZE];
+    size_t visibleCount = 0;
+
+    for (size_t begin = 0; begin < arrays.count; begin += CHUNK_SIZE)
+    {
+        BoundsArrays chunk = arrays;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            chunk.center[axis] += begin;
+            chunk.extent[axis] += begin;
+        }
+
+        chunk.radius += begin;
+        chunk.count = std::min(CHUNK_SIZE, arrays.count - begin);
+
+        const size_t chunkVisible = kernels.CullBounds(frustum.GetPlanes(), chunk, flags);
+        if (chunkVisible == 0)
+            continue;
+
+        for (size_t i = 0; i < chunk.count; ++i)
+        {
+            if (flags[i])
+                visible.push_back((uint32_t)(begin + i));
+        }
+
+        visibleCount += chunkVisible;
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Bounds.h"
+
+/*
+	The six side planes of the clip volume of a matrix, in the space of the vectors it multiplies: world space
+	for a view projection matrix, object space for a model view projection one.
+
+	Each plane is the PLANE_COEFFICIENTS entry of the clipper moved through the matrix, normalized so the dot
+	product with (x, y, z, 1) is the signed distance, positive inside. An object outside of one plane can't
+	produce a visible triangle, so it is dropped before any of its vertices is transformed.
+*/
+class Frustum
+{
+public:
+	// RIGHT to NEAR of Plane, POSITIVEW has no plane of its own in front of the camera
+	static const int PLANE_COUNT = 6;
+
+	Frustum();
+
+	explicit Frustum(const mat4f& matrix);
+
+	// Plane of Plane::RIGHT + index, xyz the inward unit normal and w the distance from the origin
+	const vec4f& GetPlane(int index) const
+	{
+		return planes[index];
+	}
+
+	const vec4f* GetPlanes() const
+	{
+		return planes;
+	}
+
+	// False when the sphere is entirely outside of one plane, an object crossing a corner can still pass
+	bool IsVisible(const BoundingSphere& sphere) const;
+
+	bool IsVisible(const AABB& box) const;
+
+private:
+	vec4f planes[PLANE_COUNT];
+};
+
+// Appends the indices of the objects of bounds not outside of frustum to visible, in order. Returns how many
+size_t CullBounds(const Frustum& frustum, const BoundsBatch& bounds, std::vector<uint32_t>& visible);
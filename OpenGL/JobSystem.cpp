@@ -0,0 +1,176 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+    // Which job system the current thread belongs to and its index in it
+    thread_local const JobSystem* currentJobSystem = nullptr;
+    thread_local int currentThreadIndex = 0;
+}
+
+JobSystem::JobSystem(int workerCount)
+    : pendingTasks(0), quit(false)
+{
+    workerCount = std::max(0, workerCount);
+
+    for (int i = 0; i <= workerCount; ++i)
+        queues.push_back(new WorkQueue());
+
+    for (int i = 1; i <= workerCount; ++i)
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        quit = true;
+    }
+    wakeUp.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (WorkQueue* queue : queues)
+        delete queue;
+}
+
+int JobSystem::GetDefaultWorkerCount()
+{
+    return std::max(0, (int)std::thread::hardware_concurrency() - 1);
+}
+
+int JobSystem::GetThreadIndex() const
+{
+    return currentJobSystem == this ? currentThreadIndex : 0;
+}
+
+void JobSystem::Run(Job job, Counter& counter)
+{
+    counter.fetch_add(1);
+
+    if (workers.empty())
+    {
+        job();
+        counter.fetch_sub(1);
+        return;
+    }
+
+    WorkQueue* queue = queues[GetThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back({ std::move(job), &counter });
+    }
+
+    if (pendingTasks.fetch_add(1) == 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeUp.notify_all();
+    }
+    else
+    {
+        wakeUp.notify_one();
+    }
+}
+
+void JobSystem::Wait(Counter& counter)
+{
+    const int thread = GetThreadIndex();
+
+    while (counter.load() > 0)
+    {
+        if (!RunOne(thread))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize, const RangeJob& body)
+{
+    grainSize = std::max<size_t>(1, grainSize);
+
+    if (workers.empty())
+    {
+        for (size_t rangeBegin = begin; rangeBegin < end; rangeBegin += grainSize)
+            body(rangeBegin, std::min(end, rangeBegin + grainSize));
+
+        return;
+    }
+
+    Counter counter(0);
+
+    // Pushed from the last range to the first, the owner pops from the back and starts at the beginning
+    size_t rangeCount = (end - begin + grainSize - 1) / grainSize;
+
+    for (size_t i = rangeCount; i-- > 0;)
+    {
+        size_t rangeBegin = begin + i * grainSize;
+        size_t rangeEnd = std::min(end, rangeBegin + grainSize);
+
+        Run([&body, rangeBegin, rangeEnd]() { body(rangeBegin, rangeEnd); }, counter);
+    }
+
+    Wait(counter);
+}
+
+bool JobSystem::Pop(int thread, Task& task)
+{
+    WorkQueue* queue = queues[thread];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+
+    if (queue->tasks.empty())
+        return false;
+
+    task = std::move(queue->tasks.back());
+    queue->tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::Steal(int thread, Task& task)
+{
+    const int queueCount = (int)queues.size();
+
+    for (int i = 1; i < queueCount; ++i)
+    {
+        WorkQueue* queue = queues[(thread + i) % queueCount];
+        std::unique_lock<std::mutex> lock(queue->mutex, std::try_to_lock);
+
+        if (!lock.owns_lock() || queue->tasks.empty())
+            continue;
+
+        task = std::move(queue->tasks.front());
+        queue->tasks.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+bool JobSystem::RunOne(int thread)
+{
+    Task task;
+
+    if (!Pop(thread, task) && !Steal(thread, task))
+        return false;
+
+    pendingTasks.fetch_sub(1);
+
+    task.job();
+    task.counter->fetch_sub(1);
+
+    return true;
+}
+
+void JobSystem::WorkerLoop(int thread)
+{
+    currentJobSystem = this;
+    currentThreadIndex = thread;
+
+    while (!quit.load())
+    {
+        if (RunOne(thread))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return pendingTasks.load() > 0 || quit.load(); });
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Work stealing job system.
+
+	Every thread owns a deque of jobs: it pushes and pops at the back, idle threads
+	steal from the front of the others, so there is no lock shared by all threads.
+	A thread waiting for its jobs keeps running jobs instead of blocking.
+
+	With 0 workers every job runs on the calling thread in submission order,
+	which makes a frame deterministic for debugging.
+
+	Jobs may be submitted from inside jobs, otherwise only the thread that created
+	the job system submits work.
+*/
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+	typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+	// Number of jobs not finished yet, Wait returns once it reaches 0
+	typedef std::atomic<int> Counter;
+
+	explicit JobSystem(int workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator = (const JobSystem&) = delete;
+
+	// Default worker count, one thread per core besides the calling thread
+	static int GetDefaultWorkerCount();
+
+	int GetWorkerCount() const
+	{
+		return (int)workers.size();
+	}
+
+	// Threads that can run jobs, the workers and the thread that created the job system
+	int GetThreadCount() const
+	{
+		return (int)workers.size() + 1;
+	}
+
+	// 0 for the thread that created the job system, 1 to GetWorkerCount for the workers
+	int GetThreadIndex() const;
+
+	void Run(Job job, Counter& counter);
+	void Wait(Counter& counter);
+
+	// Calls body over [begin, end) split in ranges of at most grainSize, returns when all of them are done
+	void ParallelFor(size_t begin, size_t end, size_t grainSize, const RangeJob& body);
+
+private:
+	struct Task
+	{
+		Job job;
+		Counter* counter;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	bool Pop(int thread, Task& task);
+	bool Steal(int thread, Task& task);
+	bool RunOne(int thread);
+	void WorkerLoop(int thread);
+
+	std::vector<std::thread> workers;
+	std::vector<WorkQueue*> queues;
+
+	// Only used to put idle workers to sleep
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	std::atomic<int> pendingTasks;
+	std::atomic<bool> quit;
+};
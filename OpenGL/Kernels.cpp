@@ -0,0 +1,161 @@
+#include "Kernels.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(KERNEL_VARIANTS) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace KernelsSse2
+{
+    const Kernels& GetTable();
+}
+
+#ifdef KERNEL_VARIANTS
+namespace KernelsAvx2
+{
+    const Kernels& GetTable();
+}
+
+namespace KernelsAvx512
+{
+    const Kernels& GetTable();
+}
+#endif // KERNEL_VARIANTS
+
+namespace
+{
+    bool IsSupported(KernelIsa isa)
+    {
+        switch (isa)
+        {
+        case KernelIsa::SSE2:
+            return true;
+
+#ifdef KERNEL_VARIANTS
+#ifdef _MSC_VER
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+        {
+            int info[4];
+            __cpuid(info, 1);
+            bool fma = (info[2] & (1 << 12)) != 0;
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            if (!osxsave)
+                return false;
+
+            // The OS has to save the YMM and for AVX-512 also the opmask and ZMM registers
+            unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(info, 7, 0);
+
+            if (isa == KernelIsa::AVX2)
+                return fma && (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+
+            bool avx512 = (info[1] & (1 << 16)) && (info[1] & (1 << 30)) && (info[1] & (1u << 31));
+            return avx512 && (xcr0 & 0xe6) == 0xe6;
+        }
+#else
+        case KernelIsa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case KernelIsa::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+#endif // _MSC_VER
+#endif // KERNEL_VARIANTS
+
+        default:
+            return false;
+        }
+    }
+
+    const Kernels* GetTable(KernelIsa isa)
+    {
+        switch (isa)
+        {
+        case KernelIsa::SSE2:
+            return &KernelsSse2::GetTable();
+#ifdef KERNEL_VARIANTS
+        case KernelIsa::AVX2:
+            return &KernelsAvx2::GetTable();
+        case KernelIsa::AVX512:
+            return &KernelsAvx512::GetTable();
+#endif // KERNEL_VARIANTS
+        default:
+            return nullptr;
+        }
+    }
+
+    const Kernels* SelectKernels()
+    {
+        // KERNEL_ISA=sse2|avx2|avx512 caps the instruction set, to compare variants on one machine
+        int highest = (int)KernelIsa::COUNT - 1;
+        if (const char* forced = std::getenv("KERNEL_ISA"))
+        {
+            for (int i = 0; i < (int)KernelIsa::COUNT; ++i)
+            {
+                if (std::strcmp(forced, GetKernelIsaName((KernelIsa)i)) == 0)
+                    highest = i;
+            }
+        }
+
+        for (int i = highest; i > 0; --i)
+        {
+            if (const Kernels* kernels = GetKernels((KernelIsa)i))
+                return kernels;
+        }
+
+        return &KernelsSse2::GetTable();
+    }
+
+    std::atomic<const Kernels*> current{ nullptr };
+}
+
+const Kernels& GetKernels()
+{
+    const Kernels* kernels = current.load(std::memory_order_acquire);
+    if (!kernels)
+    {
+        // Threads racing here all pick the same table
+        kernels = SelectKernels();
+        current.store(kernels, std::memory_order_release);
+    }
+
+    return *kernels;
+}
+
+const Kernels* GetKernels(KernelIsa isa)
+{
+    return IsSupported(isa) ? GetTable(isa) : nullptr;
+}
+
+bool SetKernelIsa(KernelIsa isa)
+{
+    const Kernels* kernels = GetKernels(isa);
+    if (!kernels)
+        return false;
+
+    current.store(kernels, std::memory_order_release);
+    return true;
+}
+
+const char* GetKernelIsaName(KernelIsa isa)
+{
+    switch (isa)
+    {
+    case KernelIsa::SSE2:
+        return "sse2";
+    case KernelIsa::AVX2:
+        return "avx2";
+    case KernelIsa::AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+void GetKernelMatrix(const mat4f& matrix, float* elements)
+{
+    for (int i = 0; i < 16; ++i)
+        elements[i] = matrix[i];
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Vector.h"
+#include "Matrix.h"
+
+struct TriangleSetup;
+struct BoundsArrays;
+struct DepthSetup;
+enum class BlendMode;
+
+// x86 builds have AVX2 and AVX-512 variants of the kernels unless NO_KERNEL_VARIANTS is defined
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(NO_KERNEL_VARIANTS)
+#define KERNEL_VARIANTS
+#endif
+
+// Number of pixels ShadeSpan handles per call
+const int SPAN_SIZE = 64;
+
+// Instruction sets the kernels are compiled for, SSE2 is the baseline build of the compiler
+enum class KernelIsa
+{
+	SSE2 = 0,
+	AVX2,
+	AVX512,
+	COUNT
+};
+
+/*
+	Hot loops compiled once per instruction set, the table for the running CPU is picked on first use.
+	Every variant gives the same results, they only differ in how wide the compiler could vectorize them.
+*/
+struct Kernels
+{
+	KernelIsa isa;
+
+	// clipVertices[i] = vec4f(positions[i]) * matrix
+	void (*TransformPositions)(const float* matrix, const vec3f* positions, vec4f* clipVertices, size_t count);
+
+	// out[i] = models[i] * matrix, the models are the 12 elements of an affine4f each and the 16 elements of out
+	// are in the layout of matrix, the one of GetKernelMatrix
+	void (*ComposeMatrices)(const float* matrix, const float* models, size_t count, float* out);
+
+	// Shades pixels minX..minX + count - 1 of row y, count <= SPAN_SIZE. Writes the BGRA color of every pixel and
+	// 1 in coverage for the ones inside the triangle, returns the number of covered pixels
+	int (*ShadeSpan)(const TriangleSetup& setup, int y, int minX, int count, uint8_t* bgra, uint8_t* coverage);
+
+	// TGA run length encoding of the pixels, scratch holds pixelCount * bytesPerPixel bytes and out at most
+	// pixelCount * (bytesPerPixel + 1) bytes. Returns the number of bytes written to out
+	size_t (*EncodeRle)(const uint8_t* pixels, size_t pixelCount, int bytesPerPixel, uint8_t* scratch, uint8_t* out);
+
+	// Blends the BGRA source pixels with a coverage of 1 into destination, same results as BlendPixel
+	void (*BlendSpan)(const uint8_t* source, const uint8_t* coverage, int count, BlendMode mode, uint8_t* destination);
+
+	// visible[i] = 1 for the objects of bounds not outside of any of the Frustum::PLANE_COUNT planes, 0 for the
+	// others. Returns the number of visible objects
+	size_t (*CullBounds)(const vec4f* planes, const BoundsArrays& bounds, uint8_t* visible);
+
+	// Depth test and write of pixels minX..minX + count - 1 of row y, the pixels the triangle covers keep the
+	// nearer of their depth and the one of the triangle
+	void (*DepthSpan)(const DepthSetup& setup, int y, int minX, int count, float* depth);
+
+	// MSAA resolve of count pixels. Pixels with a negative sample block copy their BGRA color from pixels, the
+	// others average the sampleCount (2, 4 or 8) BGRA colors from samples + block, rounded to the nearest. The
+	// first bytesPerPixel bytes of every color are written to out
+	void (*ResolveSpan)(const uint32_t* pixels, const int32_t* sampleBlocks, const uint32_t* samples, int sampleCount, int count,
+		int bytesPerPixel, uint8_t* out);
+};
+
+// Kernels for the best instruction set of the CPU, or the one forced with SetKernelIsa / the KERNEL_ISA environment variable
+const Kernels& GetKernels();
+
+// Kernels of one instruction set, nullptr when it wasn't compiled in or the CPU doesn't support it
+const Kernels* GetKernels(KernelIsa isa);
+
+// Switches GetKernels to isa, returns false and keeps the current one when it isn't available
+bool SetKernelIsa(KernelIsa isa);
+
+const char* GetKernelIsaName(KernelIsa isa);
+
+// Matrix elements in the layout TransformPositions takes
+void GetKernelMatrix(const mat4f& matrix, float* elements);
@@ -0,0 +1,8 @@
+// Compiled with -mavx2 -mfma, /arch:AVX2 with Visual Studio
+#include "Kernels.h"
+
+#ifdef KERNEL_VARIANTS
+#define KERNEL_NAMESPACE KernelsAvx2
+#define KERNEL_ISA KernelIsa::AVX2
+#include "KernelsImpl.h"
+#endif // KERNEL_VARIANTS
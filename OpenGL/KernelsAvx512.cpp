@@ -0,0 +1,8 @@
+// Compiled with -mavx512f -mavx512bw -mavx512vl, /arch:AVX512 with Visual Studio
+#include "Kernels.h"
+
+#ifdef KERNEL_VARIANTS
+#define KERNEL_NAMESPACE KernelsAvx512
+#define KERNEL_ISA KernelIsa::AVX512
+#include "KernelsImpl.h"
+#endif // KERNEL_VARIANTS
@@ -0,0 +1,405 @@
+/*
+	Kernel bodies, included once per instruction set by KernelsSse2.cpp, KernelsAvx2.cpp and KernelsAvx512.cpp
+	with KERNEL_NAMESPACE and KERNEL_ISA defined.
+
+	Only plain loops over fields belong here. An inline function or template from a shared header used in this
+	file is compiled with the wider instruction set too, and the linker is free to keep that copy for the whole
+	program, which then crashes on older CPUs.
+*/
+#include <cmath>
+#include <cstring>
+#include "Kernels.h"
+#include "Rasterizer.h"
+#include "Blend.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "OcclusionBuffer.h"
+
+namespace KERNEL_NAMESPACE
+{
+    void TransformPositions(const float* matrix, const vec3f* positions, vec4f* clipVertices, size_t count)
+    {
+        // Columns of the row vector convention, vec4f(position) has w = 1
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x = positions[i].x;
+            float y = positions[i].y;
+            float z = positions[i].z;
+
+            clipVertices[i].x = x * matrix[0] + y * matrix[4] + z * matrix[8] + matrix[12];
+            clipVertices[i].y = x * matrix[1] + y * matrix[5] + z * matrix[9] + matrix[13];
+            clipVertices[i].z = x * matrix[2] + y * matrix[6] + z * matrix[10] + matrix[14];
+            clipVertices[i].w = x * matrix[3] + y * matrix[7] + z * matrix[11] + matrix[15];
+        }
+    }
+
+    void ComposeMatrices(const float* matrix, const float* models, size_t count, float* out)
+    {
+        // In locals, the stores to out could otherwise change matrix and it would be reloaded for every instance
+        float m[16];
+        for (int i = 0; i < 16; ++i)
+            m[i] = matrix[i];
+
+        // Row r of the product is the first three rows of matrix weighted by column r of the affine layout, the
+        // translation row also adds the last row of matrix. Each row is four lanes of the same operations
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* model = models + i * 12;
+            float* result = out + i * 16;
+
+            for (int row = 0; row < 3; ++row)
+            {
+                const float a = model[row], b = model[4 + row], c = model[8 + row];
+
+                for (int col = 0; col < 4; ++col)
+                    result[row * 4 + col] = a * m[col] + b * m[4 + col] + c * m[8 + col];
+            }
+
+            const float a = model[3], b = model[7], c = model[11];
+
+            for (int col = 0; col < 4; ++col)
+                result[12 + col] = a * m[col] + b * m[4 + col] + c * m[8 + col] + m[12 + col];
+        }
+    }
+
+    int ShadeSpan(const TriangleSetup& setup, int y, int minX, int count, uint8_t* bgra, uint8_t* coverage)
+    {
+        const float x0 = setup.v0.x, y0 = setup.v0.y;
+        const float x1 = setup.v1.x, y1 = setup.v1.y;
+        const float x2 = setup.v2.x, y2 = setup.v2.y;
+
+        const VaryingPlanes& planes = setup.varyings;
+        const float py = (float)y;
+        const float dy = py - planes.originY;
+
+        // Row terms of the planes, same grouping as InterpolateVaryings
+        const float rowW = planes.bW * dy + planes.cW;
+
+#ifdef VERTEX_COLOR
+        const int first = VARYING_COLOR;
+#else
+        const int first = VARYING_TEXCOORD;
+#endif // VERTEX_COLOR
+
+        const float a0 = planes.a[first], row0 = planes.b[first] * dy + planes.c[first];
+        const float a1 = planes.a[first + 1], row1 = planes.b[first + 1] * dy + planes.c[first + 1];
+        const float a2 = planes.a[first + 2], row2 = planes.b[first + 2] * dy + planes.c[first + 2];
+
+        // Every lane is shaded, the coverage mask keeps the loop free of branches so it vectorizes
+        int covered = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            float px = (float)(minX + i);
+
+            // Same operations in the same order as EdgeWeights
+            float u = (px - x1) * (y2 - y1) - (py - y1) * (x2 - x1);
+            float s = (px - x2) * (y0 - y2) - (py - y2) * (x0 - x2);
+            float t = (px - x0) * (y1 - y0) - (py - y0) * (x1 - x0);
+
+            uint8_t inside = (u <= 0) & (s <= 0) & (t <= 0);
+            coverage[i] = inside;
+            covered += inside;
+
+            float dx = px - planes.originX;
+            float w = 1 / (planes.aW * dx + rowW);
+
+            float v0 = (a0 * dx + row0) * w;
+            float v1 = (a1 * dx + row1) * w;
+            float v2 = (a2 * dx + row2) * w;
+
+#ifdef VERTEX_COLOR
+            float r = v0;
+            float g = v1;
+            float b = v2;
+#else
+            (void)v2;
+
+            const int M = 10;
+            float p = (fmod(v0 * M, 1.0) > 0.5) ^ (fmod(v1 * M, 1.0) < 0.5);
+            float r = p, g = p, b = p;
+#endif // VERTEX_COLOR
+
+            bgra[i * 4 + 0] = (uint8_t)(int)(b * 255);
+            bgra[i * 4 + 1] = (uint8_t)(int)(g * 255);
+            bgra[i * 4 + 2] = (uint8_t)(int)(r * 255);
+            bgra[i * 4 + 3] = 255;
+        }
+
+        return covered;
+    }
+
+    size_t EncodeRle(const uint8_t* pixels, size_t pixelCount, int bytesPerPixel, uint8_t* scratch, uint8_t* out)
+    {
+        const size_t MAX_CHUNK_LENGTH = 128;
+
+        if (pixelCount == 0)
+            return 0;
+
+        // Byte j equals the same byte of the next pixel, then folded in place to one flag per pixel
+        size_t compareBytes = (pixelCount - 1) * bytesPerPixel;
+        for (size_t j = 0; j < compareBytes; ++j)
+            scratch[j] = pixels[j] == pixels[j + bytesPerPixel];
+
+        for (size_t i = 0; i + 1 < pixelCount; ++i)
+        {
+            uint8_t equal = 1;
+            for (int c = 0; c < bytesPerPixel; ++c)
+                equal &= scratch[i * bytesPerPixel + c];
+
+            scratch[i] = equal;
+        }
+
+        // Same chunks as the original per pixel writer, so files don't change
+        size_t written = 0;
+        size_t pixel = 0;
+        while (pixel < pixelCount)
+        {
+            size_t runLength = 1;
+            bool raw = true;
+
+            while (pixel + runLength < pixelCount && runLength < MAX_CHUNK_LENGTH)
+            {
+                bool equal = scratch[pixel + runLength - 1] != 0;
+                if (runLength == 1)
+                    raw = !equal;
+
+                if (raw && equal)
+                {
+                    --runLength;
+                    break;
+                }
+
+                if (!raw && !equal)
+                    break;
+
+                ++runLength;
+            }
+
+            out[written++] = (uint8_t)(raw ? runLength - 1 : runLength + 127);
+
+            size_t bytes = raw ? runLength * bytesPerPixel : bytesPerPixel;
+            const uint8_t* chunk = pixels + pixel * bytesPerPixel;
+            for (size_t j = 0; j < bytes; ++j)
+                out[written + j] = chunk[j];
+
+            written += bytes;
+            pixel += runLength;
+        }
+
+        return written;
+    }
+
+    void BlendSpan(const uint8_t* source, const uint8_t* coverage, int count, BlendMode mode, uint8_t* destination)
+    {
+        // One loop per mode so each is free of branches, x / 255 is rounded with shifts like Div255
+        switch (mode)
+        {
+        case BlendMode::REPLACE:
+            for (int i = 0; i < count; ++i)
+            {
+                for (int c = 0; c < 4; ++c)
+                    destination[i * 4 + c] = coverage[i] ? source[i * 4 + c] : destination[i * 4 + c];
+            }
+            break;
+
+        case BlendMode::ALPHA:
+            for (int i = 0; i < count; ++i)
+            {
+                const uint32_t a = source[i * 4 + 3];
+                const uint32_t inverse = 255 - a;
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t x = source[i * 4 + c] * a + destination[i * 4 + c] * inverse + 128;
+                    uint8_t blended = (uint8_t)((x + (x >> 8)) >> 8);
+                    destination[i * 4 + c] = coverage[i] ? blended : destination[i * 4 + c];
+                }
+
+                uint32_t x = destination[i * 4 + 3] * inverse + 128;
+                uint8_t blended = (uint8_t)(a + ((x + (x >> 8)) >> 8));
+                destination[i * 4 + 3] = coverage[i] ? blended : destination[i * 4 + 3];
+            }
+            break;
+
+        case BlendMode::ADDITIVE:
+            for (int i = 0; i < count; ++i)
+            {
+                const uint32_t a = source[i * 4 + 3];
+                const uint32_t inverse = 255 - a;
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t x = source[i * 4 + c] * a + 128;
+                    uint32_t sum = destination[i * 4 + c] + ((x + (x >> 8)) >> 8);
+                    uint8_t blended = (uint8_t)(sum < 255 ? sum : 255);
+                    destination[i * 4 + c] = coverage[i] ? blended : destination[i * 4 + c];
+                }
+
+                uint32_t x = destination[i * 4 + 3] * inverse + 128;
+                uint8_t blended = (uint8_t)(a + ((x + (x >> 8)) >> 8));
+                destination[i * 4 + 3] = coverage[i] ? blended : destination[i * 4 + 3];
+            }
+            break;
+
+        case BlendMode::PREMULTIPLIED:
+            for (int i = 0; i < count; ++i)
+            {
+                const uint32_t inverse = 255 - source[i * 4 + 3];
+
+                for (int c = 0; c < 4; ++c)
+                {
+                    uint32_t x = destination[i * 4 + c] * inverse + 128;
+                    uint32_t sum = source[i * 4 + c] + ((x + (x >> 8)) >> 8);
+                    uint8_t blended = (uint8_t)(sum < 255 ? sum : 255);
+                    destination[i * 4 + c] = coverage[i] ? blended : destination[i * 4 + c];
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    size_t CullBounds(const vec4f* planes, const BoundsArrays& bounds, uint8_t* visible)
+    {
+        const int PLANE_COUNT = Frustum::PLANE_COUNT;
+
+        // Plane terms in locals so the loop over the objects is the one vectorized
+        float nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], nw[PLANE_COUNT];
+        float absX[PLANE_COUNT], absY[PLANE_COUNT], absZ[PLANE_COUNT];
+
+        for (int plane = 0; plane < PLANE_COUNT; ++plane)
+        {
+            nx[plane] = planes[plane].x;
+            ny[plane] = planes[plane].y;
+            nz[plane] = planes[plane].z;
+            nw[plane] = planes[plane].w;
+
+            absX[plane] = nx[plane] < 0 ? -nx[plane] : nx[plane];
+            absY[plane] = ny[plane] < 0 ? -ny[plane] : ny[plane];
+            absZ[plane] = nz[plane] < 0 ? -nz[plane] : nz[plane];
+        }
+
+        const float* centerX = bounds.center[0];
+        const float* centerY = bounds.center[1];
+        const float* centerZ = bounds.center[2];
+        const float* extentX = bounds.extent[0];
+        const float* extentY = bounds.extent[1];
+        const float* extentZ = bounds.extent[2];
+        const float* radius = bounds.radius;
+        const size_t count = bounds.count;
+
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t inside = 1;
+
+            for (int plane = 0; plane < PLANE_COUNT; ++plane)
+            {
+                float distance = centerX[i] * nx[plane] + centerY[i] * ny[plane] + centerZ[i] * nz[plane] + nw[plane];
+
+                // Distance the box reaches towards the plane, the sphere is used when it is the tighter one
+                float boxReach = extentX[i] * absX[plane] + extentY[i] * absY[plane] + extentZ[i] * absZ[plane];
+                float reach = boxReach < radius[i] ? boxReach : radius[i];
+
+                inside &= (uint32_t)(distance + reach >= 0);
+            }
+
+            visible[i] = (uint8_t)inside;
+            visibleCount += inside;
+        }
+
+        return visibleCount;
+    }
+
+    void DepthSpan(const DepthSetup& setup, int y, int minX, int count, float* depth)
+    {
+        const float x0 = setup.x0, y0 = setup.y0;
+        const float x1 = setup.x1, y1 = setup.y1;
+        const float x2 = setup.x2, y2 = setup.y2;
+
+        const float py = (float)y;
+        const float rowDepth = setup.depthY * py + setup.depthOffset;
+
+        for (int i = 0; i < count; ++i)
+        {
+            float px = (float)(minX + i);
+
+            // Edge functions of ShadeSpan, moved in by the offsets
+            float u = (px - x1) * (y2 - y1) - (py - y1) * (x2 - x1) + setup.edgeOffset0;
+            float s = (px - x2) * (y0 - y2) - (py - y2) * (x0 - x2) + setup.edgeOffset1;
+            float t = (px - x0) * (y1 - y0) - (py - y0) * (x1 - x0) + setup.edgeOffset2;
+
+            float z = setup.depthX * px + rowDepth;
+
+            bool write = (u <= 0) & (s <= 0) & (t <= 0) & (z < depth[i]);
+            depth[i] = write ? z : depth[i];
+        }
+    }
+
+    void ResolveSpan(const uint32_t* pixels, const int32_t* sampleBlocks, const uint32_t* samples, int sampleCount, int count,
+        int bytesPerPixel, uint8_t* out)
+    {
+        // Every pixel gets its compressed color first, a copy the compiler widens when the pixel size is known
+        const uint8_t* colors = reinterpret_cast<const uint8_t*>(pixels);
+
+        if (bytesPerPixel == 4)
+        {
+            for (int i = 0; i < count * 4; ++i)
+                out[i] = colors[i];
+        }
+        else if (bytesPerPixel == 3)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                    out[i * 3 + c] = colors[i * 4 + c];
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                for (int c = 0; c < bytesPerPixel; ++c)
+                    out[i * bytesPerPixel + c] = colors[i * 4 + c];
+            }
+        }
+
+        // The edge pixels are overwritten with the average of their samples. The channels are summed two at a
+        // time in 16 bit lanes, at most 8 * 255 each, and the sample count is a power of 2 so the rounded
+        // division is a shift
+        const int shift = sampleCount == 8 ? 3 : sampleCount == 4 ? 2 : 1;
+        const uint32_t half = (uint32_t)(sampleCount / 2) * 0x00010001u;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int32_t block = sampleBlocks[i];
+            if (block < 0)
+                continue;
+
+            uint32_t evenSum = 0;
+            uint32_t oddSum = 0;
+            for (int sample = 0; sample < sampleCount; ++sample)
+            {
+                evenSum += samples[block + sample] & 0x00FF00FFu;
+                oddSum += (samples[block + sample] >> 8) & 0x00FF00FFu;
+            }
+
+            const uint32_t average = (((evenSum + half) >> shift) & 0x00FF00FFu) | ((((oddSum + half) >> shift) & 0x00FF00FFu) << 8);
+
+            uint8_t bgra[4];
+            memcpy(bgra, &average, sizeof(bgra));
+
+            for (int c = 0; c < bytesPerPixel; ++c)
+                out[i * bytesPerPixel + c] = bgra[c];
+        }
+    }
+
+    const Kernels& GetTable()
+    {
+        static const Kernels table = { KERNEL_ISA, TransformPositions, ComposeMatrices, ShadeSpan, EncodeRle, BlendSpan, CullBounds, DepthSpan,
+            ResolveSpan };
+        return table;
+    }
+}
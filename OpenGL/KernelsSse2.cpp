@@ -0,0 +1,4 @@
+// Baseline kernels, built with the default flags of the project
+#define KERNEL_NAMESPACE KernelsSse2
+#define KERNEL_ISA KernelIsa::SSE2
+#include "KernelsImpl.h"
@@ -3,318 +3,33 @@
 #include "Matrix.h"
 #include "tgaimage.h"
 #include "Triangle.h"
-#include "MathCommon.h"
+#include "Clipper.h"
+#include "FrameArena.h"
+#include "Rasterizer.h"
+#include "Msaa.h"
+#include "VisibilityBuffer.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <cstdio>
 #include <list>
 #include <vector>
 
 #define PI 3.1415926
 
-#define PERSPECTIVE_DIVIDE
-#define VERTEX_COLOR
+// Number of samples per pixel, comment out to draw aliased
+//#define MSAA_SAMPLES 4
 
-using namespace std;
-
-
-void ClearTarget(TGAImage& image, const uint32_t& width, const uint32_t& height, const TGAColor& color)
-{
-	for (uint32_t i = 0; i < width; ++i)
-	{
-		for (uint32_t j = 0; j < height; ++j)
-		{
-			image.set(i, j, color);
-		}
-	}
-}
-
-void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2)
-{
-    // Calculate the Min and MaxBounds
-    // Points to Check for
-    vec3f minBounds;
-    minBounds.x = min(v0.x, min(v1.x, v2.x));
-    minBounds.y = min(v0.y, min(v1.y, v2.y));
-
-    vec3f maxBounds;
-    maxBounds.x = max(v0.x, max(v1.x, v2.x));
-    maxBounds.y = max(v0.y, max(v1.y, v2.y));
-
-    vec3f c0 = vec3f(1, 0, 0);
-    vec3f c1 = vec3f(0, 1, 0);
-    vec3f c2 = vec3f(0, 0, 1);
-
-#ifdef PERSPECTIVE_DIVIDE
-    c0 /= v0.w;
-    c1 /= v1.w;
-    c2 /= v2.w;
-#endif // PERSPECTIVE_DIVIDE
-
-    vec3f st0 = vec3f(1, 1, 0);
-    vec3f st1 = vec3f(0, 1, 0);
-    vec3f st2 = vec3f(0, 0, 0);
-
-#ifdef PERSPECTIVE_DIVIDE
-    st0 /= v0.w;
-    st1 /= v1.w;
-    st2 /= v2.w;
-#endif // DEBUG
-
-    float area = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY());
-
-    for (int x = minBounds.x; x <= maxBounds.x; ++x)
-    {
-        for (int y = minBounds.y; y <= maxBounds.y; ++y)
-        {
-            vec3f pos = vec3f(x, y, 0);
-            // Direction Vectors
-            vec3f V0V1 = v1.GetXYZ() - v0.GetXYZ();    // From V0 to V1
-            vec3f V0V2 = v2.GetXYZ() - v0.GetXYZ();    // From V0 to V2
-            vec3f V0Pos = pos - v0.GetXYZ();  // From V0 to Pos
-
-            // Calculate the Signed Area for each edge of the triangle with the point
-            float u = vec2f::EdgeFunction(v1.GetXY(), v2.GetXY(), pos.GetXY());
-            float s = vec2f::EdgeFunction(v2.GetXY(), v0.GetXY(), pos.GetXY());
-            float t = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), pos.GetXY());
-
-            // We are checking if its less than 0, because we are considering couter clockwise vertices
-            // So out point lies inside the triangle if the weigts (lamda's) < 0
-            if (u <= 0 && s <= 0 && t <= 0 )
-            {
-                // Calculate the weight's by dividing the area of the entire triangle
-                u = u / area;
-                s = s / area;
-                t = t / area;
-
-                //  Calculate the Z interpolation (Correctly if we have defined perspective divide(Only to show the difference)
-                // interpolate z, interpolate w  and (interpolatedz/interpolatedw)
-
-#ifdef PERSPECTIVE_DIVIDE
-                float z = 1 / ((u / v0.w) + (s / v1.w) + (t / v2.w));
-#endif // PERSPECTIVE_DIVIDE
-
-                // Calculate interpolated vertex attributes
-                vec3f linearColor = (c0 * u + c1 * s + c2 * t);
-                vec3f tc = (st0 * u + st1 * s + st2 * t) ;
-
-                // multiply by interpolated Z for perspective correction
-#ifdef PERSPECTIVE_DIVIDE
-                linearColor *= z;
-                tc *= z;
-#endif // DEBUG
-
-                const int M = 10;
-                // checkerboard pattern
-                float p = (fmod(tc.x * M, 1.0) > 0.5) ^ (fmod(tc.y * M, 1.0) < 0.5);
-                TGAColor color;
-
-#ifdef VERTEX_COLOR
-                color = TGAColor(linearColor.x * 255, linearColor.y * 255, linearColor.z * 255);
-#endif // VERTEX_COLOR
-
-#ifndef VERTEX_COLOR
-                color = TGAColor(p * 255, p * 255, p * 255);
-#endif // !VERTEX_COLOR
-
-
-                image.set(pos.x, pos.y, color);
-            }
-        }
-    }
-}
-
-
-void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, vec3f c0, vec3f c1, vec3f c2)
-{
-    // Calculate the Min and MaxBounds
-    // Points to Check for
-    vec3f minBounds;
-    minBounds.x = min(v0.x, min(v1.x, v2.x));
-    minBounds.y = min(v0.y, min(v1.y, v2.y));
-
-    vec3f maxBounds;
-    maxBounds.x = max(v0.x, max(v1.x, v2.x));
-    maxBounds.y = max(v0.y, max(v1.y, v2.y));
-
-
-#ifdef PERSPECTIVE_DIVIDE
-    c0 /= v0.w;
-    c1 /= v1.w;
-    c2 /= v2.w;
-#endif // PERSPECTIVE_DIVIDE
-
-    vec3f st0 = vec3f(1, 1, 0);
-    vec3f st1 = vec3f(0, 1, 0);
-    vec3f st2 = vec3f(0, 0, 0);
-
-#ifdef PERSPECTIVE_DIVIDE
-    st0 /= v0.w;
-    st1 /= v1.w;
-    st2 /= v2.w;
-#endif // DEBUG
-
-    float area = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY());
-
-    for (int x = minBounds.x; x <= maxBounds.x; ++x)
-    {
-        for (int y = minBounds.y; y <= maxBounds.y; ++y)
-        {
-            vec3f pos = vec3f(x, y, 0);
-            // Direction Vectors
-            vec3f V0V1 = v1.GetXYZ() - v0.GetXYZ();    // From V0 to V1
-            vec3f V0V2 = v2.GetXYZ() - v0.GetXYZ();    // From V0 to V2
-            vec3f V0Pos = pos - v0.GetXYZ();  // From V0 to Pos
-
-            // Calculate the Signed Area for each edge of the triangle with the point
-            float u = vec2f::EdgeFunction(v1.GetXY(), v2.GetXY(), pos.GetXY());
-            float s = vec2f::EdgeFunction(v2.GetXY(), v0.GetXY(), pos.GetXY());
-            float t = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), pos.GetXY());
-
-            // We are checking if its less than 0, because we are considering couter clockwise vertices
-            // So out point lies inside the triangle if the weigts (lamda's) < 0
-            if (u <= 0 && s <= 0 && t <= 0)
-            {
-                // Calculate the weight's by dividing the area of the entire triangle
-                u = u / area;
-                s = s / area;
-                t = t / area;
-
-                //  Calculate the Z interpolation (Correctly if we have defined perspective divide(Only to show the difference)
-                // interpolate z, interpolate w  and (interpolatedz/interpolatedw)
-
-#ifdef PERSPECTIVE_DIVIDE
-                float z = 1 / ((u / v0.w) + (s / v1.w) + (t / v2.w));
-#endif // PERSPECTIVE_DIVIDE
-
-                // Calculate interpolated vertex attributes
-                vec3f linearColor = (c0 * u + c1 * s + c2 * t);
-                vec3f tc = (st0 * u + st1 * s + st2 * t);
-
-                // multiply by interpolated Z for perspective correction
-#ifdef PERSPECTIVE_DIVIDE
-                linearColor *= z;
-                tc *= z;
-#endif // DEBUG
-
-                const int M = 10;
-                // checkerboard pattern
-                float p = (fmod(tc.x * M, 1.0) > 0.5) ^ (fmod(tc.y * M, 1.0) < 0.5);
-                TGAColor color;
-
-#ifdef VERTEX_COLOR
-                color = TGAColor(linearColor.x * 255, linearColor.y * 255, linearColor.z * 255);
-#endif // VERTEX_COLOR
-
-#ifndef VERTEX_COLOR
-                color = TGAColor(p * 255, p * 255, p * 255);
-#endif // !VERTEX_COLOR
-
-
-                image.set(pos.x, pos.y, color);
-            }
-        }
-    }
-}
-
-void ClipAgainstPlane(const Triangle& triangle, std::list<Triangle>& outlist, Plane plane)
-{
-    bool isV0Inside = IsInsidePlane(plane, triangle.vertices[0]);
-    bool isV1Inside = IsInsidePlane(plane, triangle.vertices[1]);
-    bool isV2Inside = IsInsidePlane(plane, triangle.vertices[2]);
-
-    if (isV0Inside && isV1Inside && isV2Inside)
-    {
-        outlist.push_back(triangle);
-        return;
-    }
-
-    else if (!isV0Inside && !isV1Inside && !isV2Inside)
-    {
-        return;
-    }
+// Rasterize triangle ids first and shade the visible pixels afterwards
+//#define VISIBILITY_BUFFER
 
-    else
-    {
-        std::vector<vec4f> vertices;
-        std::vector<vec3f> colors;
-
-        for (int i = 0; i < 3; ++i)
-        {
-            vec4f prev = triangle.vertices[(i + 2) % 3];
-            vec4f curr = triangle.vertices[i];
-
-            vec3f prevC = triangle.colors[(i + 2) % 3];
-            vec3f currC = triangle.colors[i];
-
-            bool isPrevInside = IsInsidePlane(plane, prev);
-            bool isCurrInside = IsInsidePlane(plane, curr);
-
-            if (isPrevInside != isCurrInside)
-            {
-                float ratio = GetIntersectionRatio(plane, curr, prev);
-
-                vec4f point = prev + (curr - prev) * ratio;
-                vec3f color = prevC + (currC - prevC) * ratio;
-
-                vertices.push_back(point);
-                colors.push_back(color);
-            }
-
-            if (isCurrInside)
-            {
-                vertices.push_back(curr);
-                colors.push_back(currC);
-            }
-        }
+// Also render the triangle spinning for this many frames, one TGA per frame
+//#define ANIMATION_FRAMES 60
 
-        for (int i = 0; i < vertices.size() - 2; ++i)
-        {
-            outlist.push_back(Triangle(vertices[0], vertices[i + 1], vertices[i + 2], colors[0], colors[i+1], colors[i+2]));
-        }
-    }
-
-}
-
-
-void ClipTriangle(const Triangle& triangle, std::list<Triangle>& outList)
-{
-    // Lamda to check if the triangle is inside view frustrum
-    auto compare = [](const vec4f& vertex)
-    {
-        return (fabsf(vertex.x) <= vertex.w && fabsf(vertex.y) <= vertex.w && fabsf(vertex.z) <= vertex.w);
-    };
-
-    // Check if Entire triangle is inside View Frustum
-    if (compare(triangle.vertices[0]) && compare(triangle.vertices[1]) && compare(triangle.vertices[2]))
-    {
-        outList.push_back(triangle);
-
-        return;
-    }
-
-    // One more list to swap the triangles
-    std::list<Triangle> inTriList;
-
-    inTriList.push_back(triangle);
-
-
-    auto loopOver = [](std::list<Triangle>& inList, std::list<Triangle>& outList, Plane plane)
-    {
-        while (inList.size() > 0)
-        {
-            ClipAgainstPlane(inList.front(), outList, plane);
-
-            inList.pop_front(); //
-        }
-    };
+using namespace std;
 
-    loopOver(inTriList, outList, Plane::POSITIVEW); 
-    loopOver(outList, inTriList, Plane::RIGHT);
-    loopOver(inTriList, outList, Plane::LEFT);
-    loopOver(outList, inTriList, Plane::TOP);
-    loopOver(inTriList, outList, Plane::BOTTOM);
-    loopOver(outList, inTriList, Plane::NEAR);
-    loopOver(inTriList, outList, Plane::FAR);
-
-}
 
 void ConvertToRasterSpace(const vec3f& vertex, vec3f& rasterVertex,
     const float& r, const float& t, const float& l, const float& b, const float& near,
@@ -337,6 +52,44 @@ void ConvertToRasterSpace(const vec3f& vertex, vec3f& rasterVertex,
     rasterVertex.z = vertex_ndc.z;
 }
 
+#ifdef ANIMATION_FRAMES
+// Spins the mesh around the y axis through its center, geometry, raster and encode of different frames overlap
+void RenderAnimation(const Mesh& mesh, const perspective4f& projectionMatrix, uint32_t width, uint32_t height)
+{
+    vec3f center;
+    for (const vec3f& position : mesh.positions)
+        center += position;
+
+    center *= 1.0f / mesh.positions.size();
+
+    FramePipeline pipeline(width, height, TGAColor(0, 0, 0));
+
+    // Only the geometry thread uses it, one frame after the other
+    GeometryContext geometryContext;
+
+    auto geometry = [&](int frame, TriangleBatch& triangles)
+    {
+        affine4f model = affine4f::Translation(-center.x, -center.y, -center.z)
+            * affine4f::Rotation(vec3f(0, 1, 0), 2 * PI * frame / ANIMATION_FRAMES)
+            * affine4f::Translation(center.x, center.y, center.z);
+
+        mat4f modelViewProjection = model * projectionMatrix;
+
+        ProcessGeometry(geometryContext, mesh, modelViewProjection, width, height, triangles);
+    };
+
+    auto encode = [](int frame, const TGAImage& image)
+    {
+        char filename[32];
+        snprintf(filename, sizeof(filename), "Animation_%03d.tga", frame);
+        image.write_tga_file(filename);
+    };
+
+    pipeline.Run(ANIMATION_FRAMES, geometry, encode);
+    pipeline.PrintTiming(cout);
+}
+#endif // ANIMATION_FRAMES
+
 
 int main()
 {
@@ -366,9 +119,7 @@ int main()
     //Calculate RasterSpace position of the vertices
     vec4f rasterv0, rasterv1, rasterv2;
 
-    mat4f projectionMatrix;
-
-    mat4f::CreateProjectionMatrix(projectionMatrix, right, left, top, bottom, zNear, zFar);
+    perspective4f projectionMatrix(right, left, top, bottom, zNear, zFar);
     vec4f clip0, clip1, clip2;
 
     // Might feel like its a column major;
@@ -378,38 +129,73 @@ int main()
 
     Triangle tri(clip0, clip1, clip2);
 
-    // List to hold all the new clipped triangles
-    std::list<Triangle> outTriangleList;
+    // Owns the transient memory of the frame
+    FrameArena frameArena;
 
-    ClipTriangle(tri, outTriangleList);
+    // List to hold all the new clipped triangles
+    TriangleList outTriangleList(&frameArena.Get());
 
-    auto convert = [](const vec4f& clipVertex, float width, float height) -> vec4f
     {
-        // Perspective division
-        vec4f ndcVertex = clipVertex;
-        ndcVertex.x = clipVertex.x / clipVertex.w;
-        ndcVertex.y = clipVertex.y / clipVertex.w;
-        ndcVertex.z = clipVertex.z / clipVertex.w;
+        PROFILE_SCOPE("clip");
+        ClipTriangle(tri, outTriangleList);
+    }
 
-        ndcVertex.x = (ndcVertex.x + 1) * 0.5f * width; // 0-widht range
+#ifdef MSAA_SAMPLES
+    // Anti-aliased edges without rendering at a higher resolution and scaling the image down
+    MsaaTarget msaaTarget(Width, Height, MSAA_SAMPLES);
+    msaaTarget.Clear(TGAColor(0, 0, 0));
+#endif // MSAA_SAMPLES
 
-        // in raster space Y is down, top left corner of the screen is (0, 0)
-        ndcVertex.y = (1 - ndcVertex.y) * 0.5f * height; // 0-height range
-        ndcVertex.z = (ndcVertex.z + 1) * 0.5f;         // 0-1 range
+#ifdef VISIBILITY_BUFFER
+    VisibilityBuffer visibilityBuffer(Width, Height);
+#endif // VISIBILITY_BUFFER
 
-        return ndcVertex;
-    };
+    // Few-pixel triangles are collected and drawn together, flush before drawing a larger one to keep the order
+    SmallTriangleBatch smallTriangles(image);
 
     for (auto itr : outTriangleList)
     {
-        rasterv0 = convert(itr.vertices[0], Width, Height);
-        rasterv1 = convert(itr.vertices[1], Width, Height);
-        rasterv2 = convert(itr.vertices[2], Width, Height);
+        PROFILE_SCOPE("convert and raster");
 
+        rasterv0 = ConvertToRaster(itr.vertices[0], Width, Height);
+        rasterv1 = ConvertToRaster(itr.vertices[1], Width, Height);
+        rasterv2 = ConvertToRaster(itr.vertices[2], Width, Height);
 
-#ifdef PERSPECTIVE_DIVIDE
-        DrawTriangleBC(image, rasterv0, rasterv1, rasterv2, itr.colors[0], itr.colors[1], itr.colors[2]);
 
+#if defined(MSAA_SAMPLES)
+        msaaTarget.DrawTriangle(rasterv0, rasterv1, rasterv2, itr.colors[0], itr.colors[1], itr.colors[2]);
+#elif defined(VISIBILITY_BUFFER)
+        visibilityBuffer.AddTriangle(rasterv0, rasterv1, rasterv2, itr.colors[0], itr.colors[1], itr.colors[2]);
+#elif defined(PERSPECTIVE_DIVIDE)
+        if (IsSmallTriangle(rasterv0, rasterv1, rasterv2))
+        {
+            smallTriangles.Add(rasterv0, rasterv1, rasterv2, itr.colors[0], itr.colors[1], itr.colors[2]);
+        }
+        else
+        {
+            smallTriangles.Flush();
+            DrawTriangleBC(image, rasterv0, rasterv1, rasterv2, itr.colors[0], itr.colors[1], itr.colors[2]);
+        }
+#else
+        DrawTriangleBC(image, rasterv0, rasterv1, rasterv2);
+#endif // MSAA_SAMPLES
+    }
+
+    smallTriangles.Flush();
+
+#ifdef MSAA_SAMPLES
+    msaaTarget.Resolve(image);
+#endif // MSAA_SAMPLES
+
+#ifdef VISIBILITY_BUFFER
+    JobSystem jobs(JobSystem::GetDefaultWorkerCount());
+    visibilityBuffer.Shade(image, jobs);
+#endif // VISIBILITY_BUFFER
+
+    {
+        PROFILE_SCOPE("write");
+
+#ifdef PERSPECTIVE_DIVIDE
 #ifndef VERTEX_COLOR
         image.write_tga_file("TrianglePerstc.tga");
 #endif // !VERTEX_COLOR
@@ -418,10 +204,7 @@ int main()
 #endif // VERTEX_COLOR
 #endif // PERSPECTIVE_DIVIDE
 
-
 #ifndef PERSPECTIVE_DIVIDE
-        DrawTriangleBC(image, rasterv0, rasterv1, rasterv2);
-
 #ifndef VERTEX_COLOR
         image.write_tga_file("TriangleNoPerstc.tga");
 #endif // !VERTEX_COLOR
@@ -430,5 +213,24 @@ int main()
 #endif // VERTEX_COLOR
 #endif // PERSPECTIVE_DIVIDE
     }
+
+#ifdef ANIMATION_FRAMES
+    Mesh mesh;
+    mesh.positions = { v0, v1, v2 };
+    mesh.colors = { vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1) };
+    mesh.indices = { 0, 1, 2 };
+
+    RenderAnimation(mesh, projectionMatrix, Width, Height);
+#endif // ANIMATION_FRAMES
+
+    // End of the frame, the clipped triangles go back to the arena
+    outTriangleList.clear();
+    frameArena.Reset();
+
+#ifdef ENABLE_PROFILING
+    Profiler::PrintSummary(cout);
+    Profiler::WriteChromeTrace("trace.json");
+#endif // ENABLE_PROFILING
+
     return 0;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <cfloat>
 #include "Vector.h"
 
 enum class Plane
@@ -12,50 +13,64 @@ enum class Plane
     NEAR
 };
 
-static bool IsInsidePlane(Plane plane, const vec4f& vertex)
+/*
+	Every frustum plane as a signed distance: dot(coefficients, vertex) + offset is not negative inside of it.
+	One table instead of a switch per plane lets the same code test a vertex, or a batch of them, against any plane.
+	The dot product of RIGHT is w - x exactly, so the results are the ones of the comparisons x <= w and so on.
+*/
+struct PlaneCoefficients
 {
-    switch (plane)
-    {
-    case Plane::POSITIVEW:
-        return vertex.w >= FLT_EPSILON;
-    case Plane::RIGHT:
-        return vertex.x <= vertex.w;
-    case Plane::LEFT:
-        return vertex.x >= -vertex.w;
-    case Plane::TOP:
-        return vertex.y <= vertex.w;
-    case Plane::BOTTOM:
-        return vertex.y >= -vertex.w;
-    case Plane::FAR:
-        return vertex.z <= vertex.w;
-    case Plane::NEAR:
-        return vertex.z >= -vertex.w;
-    default:
-        return false;
-    }
+    float x, y, z, w;
+    float offset;
+};
+
+// Indexed by Plane
+static const PlaneCoefficients PLANE_COEFFICIENTS[] =
+{
+    { 0, 0, 0, 1, -FLT_EPSILON },   // POSITIVEW
+    { -1, 0, 0, 1, 0 },             // RIGHT
+    { 1, 0, 0, 1, 0 },              // LEFT
+    { 0, -1, 0, 1, 0 },             // TOP
+    { 0, 1, 0, 1, 0 },              // BOTTOM
+    { 0, 0, -1, 1, 0 },             // FAR
+    { 0, 0, 1, 1, 0 }               // NEAR
+};
+
+// Distance to plane without the offset, which only POSITIVEW has
+inline float GetPlaneDot(const PlaneCoefficients& plane, float x, float y, float z, float w)
+{
+    return x * plane.x + y * plane.y + z * plane.z + w * plane.w;
+}
+
+inline bool IsInsidePlane(Plane plane, const vec4f& vertex)
+{
+    const PlaneCoefficients& coefficients = PLANE_COEFFICIENTS[(int)plane];
+
+    return GetPlaneDot(coefficients, vertex.x, vertex.y, vertex.z, vertex.w) + coefficients.offset >= 0;
 }
 
-static float GetIntersectionRatio(Plane plane, const vec4f& current, const vec4f& previous)
+// Inside of every plane of the table, the test the clippers accept whole triangles with
+inline bool IsInsideFrustum(const vec4f& vertex)
 {
-    switch (plane)
+    for (int plane = 0; plane <= (int)Plane::NEAR; ++plane)
     {
-    case Plane::POSITIVEW:
-        return (previous.w - FLT_EPSILON) / (previous.w - current.w);
-    case Plane::RIGHT:
-        return (previous.w - previous.x) / ((previous.w - previous.x) - (current.w - current.x));
-    case Plane::LEFT:
-        return (previous.w + previous.x) / ((previous.w + previous.x) - (current.w + current.x));
-    case Plane::TOP:
-        return (previous.w - previous.y) / ((previous.w - previous.y) - (current.w - current.y));
-    case Plane::BOTTOM:
-        return (previous.w + previous.y) / ((previous.w + previous.y) - (current.w + current.y));
-    case Plane::FAR:
-        return (previous.w - previous.z) / ((previous.w - previous.z) - (current.w - current.z));
-    case Plane::NEAR:
-        return (previous.w + previous.z) / ((previous.w + previous.z) - (current.w + current.z));
-    default:
-        return 0;
+        if (!IsInsidePlane((Plane)plane, vertex))
+            return false;
     }
 
-    return 0;
-}
\ No newline at end of file
+    return true;
+}
+
+// Ratio along previous to current where the edge crosses plane, from the plane dots of both ends
+inline float GetIntersectionRatio(const PlaneCoefficients& plane, float currentDot, float previousDot)
+{
+    return (previousDot + plane.offset) / (previousDot - currentDot);
+}
+
+inline float GetIntersectionRatio(Plane plane, const vec4f& current, const vec4f& previous)
+{
+    const PlaneCoefficients& coefficients = PLANE_COEFFICIENTS[(int)plane];
+
+    return GetIntersectionRatio(coefficients, GetPlaneDot(coefficients, current.x, current.y, current.z, current.w),
+        GetPlaneDot(coefficients, previous.x, previous.y, previous.z, previous.w));
+}
@@ -1,6 +1,12 @@
 #pragma once
 #include "Matrix3.h"
 #include "Matrix4.h"
+#include "AffineMatrix4.h"
+#include "PerspectiveMatrix.h"
+#include "TRS.h"
 
 typedef Matrix3<float> mat3f;
-typedef Matrix4<float> mat4f;
\ No newline at end of file
+typedef Matrix4<float> mat4f;
+typedef AffineMatrix4<float> affine4f;
+typedef PerspectiveMatrix<float> perspective4f;
+typedef TRS<float> trsf;
\ No newline at end of file
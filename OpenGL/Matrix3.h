@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <cmath>
+#include <type_traits>
 #include "Vector.h"
 
 template <class Type>
@@ -9,37 +11,32 @@ private:
 	std::array<Type, 9> elements;
 
 public:
-	Matrix3()
+	constexpr Matrix3()
 		: elements({ 0 })
 	{}
 
-	Matrix3(Type _00, Type _01, Type _02,
+	constexpr Matrix3(Type _00, Type _01, Type _02,
 			Type _10, Type _11, Type _12,
 			Type _20, Type _21, Type _22)
 		: elements({_00, _01, _02, _10, _11, _12, _20, _21, _22})
 	{}
 
-	Matrix3(const vec3<Type>& r1, const vec3<Type>& r2, const vec3<Type>& r3)
+	constexpr Matrix3(const vec3<Type>& r1, const vec3<Type>& r2, const vec3<Type>& r3)
 		: elements({r1.x, r1.y, r1.z, r2.x, r2.y, r2.z, r3.x, r3.y, r3.z})
 	{
 	}
 
-	Matrix3(const Matrix3& other)
-	{
-		elements = other.elements;
-	}
-
-	Type operator [] (const int index) const
+	constexpr Type operator [] (const int index) const
 	{
 		return elements[index];
 	}
 
-	Type& operator [] (const int index)
+	constexpr Type& operator [] (const int index)
 	{
 		return elements[index];
 	}
 
-	vec3<Type> GetRow(const int index) const
+	constexpr vec3<Type> GetRow(const int index) const
 	{
 		if (index >= 0 && index < 3)
 		{
@@ -51,7 +48,7 @@ public:
 		return vec3<Type>();
 	}
 
-	vec3<Type> GetCol(const int index) const
+	constexpr vec3<Type> GetCol(const int index) const
 	{
 		if (index >= 0 && index < 3)
 		{
@@ -63,7 +60,7 @@ public:
 		return vec3<Type>();
 	}
 
-	Matrix3 operator + (const Matrix3 & other)
+	constexpr Matrix3 operator + (const Matrix3 & other) const
 	{
 		Matrix3 result;
 		for (int i = 0; i < 9; ++i)
@@ -74,7 +71,7 @@ public:
 		return result;
 	}
 
-	Matrix3 operator - (const Matrix3& other)
+	constexpr Matrix3 operator - (const Matrix3& other) const
 	{
 		Matrix3 result;
 		for (int i = 0; i < 9; ++i)
@@ -84,7 +81,7 @@ public:
 		return result;
 	}
 
-	Matrix3 operator * (const Type scalar)
+	constexpr Matrix3 operator * (const Type scalar) const
 	{
 		Matrix3 result;
 		for (int i = 0; i < 9; ++i)
@@ -95,7 +92,7 @@ public:
 		return result;
 	}
 
-	Matrix3 operator / (const Type scalar)
+	constexpr Matrix3 operator / (const Type scalar) const
 	{
 		Matrix3 result;
 		Type invS = 1 / scalar;
@@ -108,7 +105,7 @@ public:
 		return result;
 	}
 
-	Matrix3 operator * (const Matrix3& other)
+	constexpr Matrix3 operator * (const Matrix3& other) const
 	{
 		Matrix3 result;
 
@@ -134,7 +131,7 @@ public:
 	}
 
 
-	static void Multiply (const Matrix3& left, const Matrix3& right, Matrix3& result)
+	static constexpr void Multiply (const Matrix3& left, const Matrix3& right, Matrix3& result)
 	{
 
 		vec3<Type> r0 = left.GetRow(0);
@@ -157,7 +154,7 @@ public:
 
 	}
 
-	vec3<Type> operator * (const vec3<Type>& vector)
+	constexpr vec3<Type> operator * (const vec3<Type>& vector) const
 	{
 		vec3<Type> result;
 
@@ -172,7 +169,7 @@ public:
 		return result;
 	}
 
-	static void Multiply (const Matrix3& matrix, const vec3<Type>& vector, vec3<Type>& result)
+	static constexpr void Multiply (const Matrix3& matrix, const vec3<Type>& vector, vec3<Type>& result)
 	{
 		vec3<Type> col0 = matrix.GetCol(0);
 		vec3<Type> col1 = matrix.GetCol(1);
@@ -183,7 +180,7 @@ public:
 		result.z = vector.Dot(col2);
 	}
 
-	Matrix3 Inverse()
+	constexpr Matrix3 Inverse() const
 	{
 		Type determinant = Determinant();
 		if (determinant == 0.0f)
@@ -204,7 +201,7 @@ public:
 	
 	*/
 
-	Type Determinant()
+	constexpr Type Determinant() const
 	{
 		Type determinant =
 			elements[0] * (elements[4] * elements[8] - elements[5] * elements[7])
@@ -226,7 +223,7 @@ public:
 
 	*/
 
-	Matrix3 Adjoint()
+	constexpr Matrix3 Adjoint() const
 	{
 		Matrix3 adjoint;
 
@@ -243,7 +240,7 @@ public:
 		return adjoint.Transpose();
 	}
 
-	Matrix3 Transpose()
+	constexpr Matrix3 Transpose() const
 	{
 		Matrix3 transpose;
 		for (int i = 0; i < 3; ++i)
@@ -257,6 +254,32 @@ public:
 		return transpose;
 	}
 
+	// Rotation of angle radians around axis, counter clockwise when looking down the axis
+	static Matrix3 Rotation(const vec3<Type>& axis, float angle)
+	{
+		Type length = (Type)sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+		Type x = axis.x / length;
+		Type y = axis.y / length;
+		Type z = axis.z / length;
+
+		Type c = (Type)cos(angle);
+		Type s = (Type)sin(angle);
+		Type t = 1 - c;
+
+		// Transpose of the usual column vector form, same as Matrix4::CreateRotationMatrix
+		return Matrix3(c + x * x * t, y * x * t + z * s, z * x * t - y * s,
+			x * y * t - z * s, c + y * y * t, z * y * t + x * s,
+			x * z * t + y * s, y * z * t - x * s, c + z * z * t);
+	}
+
 	static const Matrix3 IDENTITY;
 	static const Matrix3 ZERO;
-};
\ No newline at end of file
+};
+
+template <class Type>
+constexpr Matrix3<Type> Matrix3<Type>::IDENTITY = Matrix3<Type>(1, 0, 0, 0, 1, 0, 0, 0, 1);
+
+template <class Type>
+constexpr Matrix3<Type> Matrix3<Type>::ZERO = Matrix3<Type>();
+
+static_assert(std::is_trivially_copyable<Matrix3<float>>::value, "Matrix3 is copied as plain memory");
@@ -1,4 +0,0 @@
-#include "Matrix4.h"
-
-template<> const Matrix4<float> Matrix4<float>::ZERO(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
-template<> const Matrix4<float> Matrix4<float>::IDENTITY(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
\ No newline at end of file
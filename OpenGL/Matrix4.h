@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <cmath>
+#include <type_traits>
 #include "Vector.h"
 
 template <class Type>
@@ -10,32 +12,27 @@ private:
 
 public:
 
-	Matrix4()
+	constexpr Matrix4()
 		: elements({ 0 })
 	{}
 
-	Matrix4(Type _00, Type _01, Type _02, Type _03,
+	constexpr Matrix4(Type _00, Type _01, Type _02, Type _03,
 		Type _10, Type _11, Type _12, Type _13,
 		Type _20, Type _21, Type _22, Type _23,
 		Type _30, Type _31, Type _32, Type _33)
 		: elements({ _00, _01, _02, _03, _10, _11, _12, _13, _20, _21, _22, _23, _30, _31, _32, _33 })
 	{}
 
-	Matrix4(vec4<Type> r0, vec4<Type> r1, vec4<Type> r2, vec4<Type> r3)
+	constexpr Matrix4(vec4<Type> r0, vec4<Type> r1, vec4<Type> r2, vec4<Type> r3)
 		: elements({ r0.x, r0.y, r0.z, r0.w, r1.x, r1.y, r1.z, r1.w, r2.x, r2.y, r2.z, r2.w, r3.x, r3.y, r3.z, r3.w })
 	{}
 
-	Matrix4(const Matrix4& other)
-	{
-		elements = other.elements;
-	}
-
-	Type operator [] (const int index) const
+	constexpr Type operator [] (const int index) const
 	{
 		return elements[index];
 	}
 
-	Type& operator [] (const int index)
+	constexpr Type& operator [] (const int index)
 	{
 		return elements[index];
 	}
@@ -49,7 +46,7 @@ public:
 
 	*/
 
-	vec4<Type> GetRow(const int index) const
+	constexpr vec4<Type> GetRow(const int index) const
 	{
 		if (index >= 0 && index < 4)
 		{
@@ -70,7 +67,7 @@ public:
 		r3	|	12	13	14	15	|
 
 	*/
-	vec4<Type> GetCol(const int index) const
+	constexpr vec4<Type> GetCol(const int index) const
 	{
 		if (index >= 0 && index < 4)
 		{
@@ -83,7 +80,7 @@ public:
 		return vec4<Type>();
 	}
 
-	Matrix4 operator + (const Matrix4& other)
+	constexpr Matrix4 operator + (const Matrix4& other) const
 	{
 		Matrix4 result;
 		for (int i = 0; i < 16; ++i)
@@ -94,7 +91,7 @@ public:
 		return result;
 	}
 
-	Matrix4 operator - (const Matrix4& other)
+	constexpr Matrix4 operator - (const Matrix4& other) const
 	{
 		Matrix4 result;
 		for (int i = 0; i < 16; ++i)
@@ -104,7 +101,7 @@ public:
 		return result;
 	}
 
-	Matrix4 operator * (const Type scalar)
+	constexpr Matrix4 operator * (const Type scalar) const
 	{
 		Matrix4 result;
 		for (int i = 0; i < 16; ++i)
@@ -115,7 +112,7 @@ public:
 		return result;
 	}
 
-	Matrix4 operator / (const Type scalar)
+	constexpr Matrix4 operator / (const Type scalar) const
 	{
 		Matrix4 result;
 		Type invS = 1 / scalar;
@@ -128,7 +125,7 @@ public:
 		return result;
 	}
 
-	Matrix4 operator * (const Matrix4& other)
+	constexpr Matrix4 operator * (const Matrix4& other) const
 	{
 		Matrix4 result;
 
@@ -165,7 +162,7 @@ public:
 		return result;
 	}
 
-	vec4<Type> operator * (const vec4<Type>& vector) const 
+	constexpr vec4<Type> operator * (const vec4<Type>& vector) const 
 	{
 		vec4<Type> result;
 		   
@@ -182,7 +179,7 @@ public:
 		return result;
 	}
 
-	Matrix4 Transpose()
+	constexpr Matrix4 Transpose() const
 	{
 		Matrix4 transpose;
 		for (int i = 0; i < 4; ++i)
@@ -196,7 +193,7 @@ public:
 		return transpose;
 	}
 
-	Matrix4 Inverse()
+	constexpr Matrix4 Inverse() const
 	{
 		Type determinant = Determinant();
 
@@ -223,10 +220,10 @@ public:
 
 	*/
 
-	Type Determinant()
+	constexpr Type Determinant() const
 	{
 		Type determinant =
-			elements[0] * elements[5] * elements[10] * elements[11]
+			elements[0] * elements[5] * elements[10] * elements[15]
 			+ elements[0] * elements[6] * elements[11] * elements[13]
 			+ elements[0] * elements[7] * elements[9] * elements[14]
 			- elements[0] * elements[7] * elements[10] * elements[13]
@@ -268,7 +265,7 @@ public:
 
 	*/
 
-	Matrix4 Adjoint()
+	constexpr Matrix4 Adjoint() const
 	{
 		Matrix4 adjoint;
 		adjoint[0] = +(elements[5] * elements[10] * elements[15]
@@ -401,9 +398,10 @@ public:
 		return adjoint.Transpose();
 	}
 
-	static void CreateProjectionMatrix(Matrix4& projectionMatrix, float right, float left, float top, float bottom, float near, float far)
+	// Perspective projection of the frustum given by its sides on the near plane, the camera looks down -z
+	static constexpr Matrix4 Projection(float right, float left, float top, float bottom, float near, float far)
 	{
-		projectionMatrix = ZERO;
+		Matrix4 projectionMatrix;
 
 		// For x
 		projectionMatrix[0] = (2 * near) / (right - left);
@@ -419,9 +417,120 @@ public:
 
 		// For w
 		projectionMatrix[11] = -1;
+
+		return projectionMatrix;
+	}
+
+	static constexpr void CreateProjectionMatrix(Matrix4& projectionMatrix, float right, float left, float top, float bottom, float near, float far)
+	{
+		projectionMatrix = Projection(right, left, top, bottom, near, far);
+	}
+
+	/*
+		Vectors are multiplied as rows (v * M), the translation is in the last row
+
+		|	1	0	0	0	|
+		|	0	1	0	0	|
+		|	0	0	1	0	|
+		|	x	y	z	1	|
+	*/
+	static constexpr Matrix4 Translation(float x, float y, float z)
+	{
+		return Matrix4(1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			x, y, z, 1);
+	}
+
+	static constexpr void CreateTranslationMatrix(Matrix4& translationMatrix, float x, float y, float z)
+	{
+		translationMatrix = Translation(x, y, z);
+	}
+
+	/*
+		View matrix of a camera at eye looking at target, up only has to be off the view direction.
+		Right, up and back axes of the camera are the columns, so v * M gives camera space with -z forward
+		like Projection expects
+
+		|	rx	ux	bx	0	|
+		|	ry	uy	by	0	|
+		|	rz	uz	bz	0	|
+		|	-r.e	-u.e	-b.e	1	|
+	*/
+	static constexpr Matrix4 LookAt(const vec3<Type>& eye, const vec3<Type>& target, const vec3<Type>& up)
+	{
+		vec3<Type> back = eye - target;
+		back /= Sqrt(back.SqrMagnitude());
+
+		vec3<Type> right = vec3<Type>::Cross(up, back);
+		right /= Sqrt(right.SqrMagnitude());
+
+		vec3<Type> cameraUp = vec3<Type>::Cross(back, right);
+
+		return Matrix4(right.x, cameraUp.x, back.x, 0,
+			right.y, cameraUp.y, back.y, 0,
+			right.z, cameraUp.z, back.z, 0,
+			-right.Dot(eye), -cameraUp.Dot(eye), -back.Dot(eye), 1);
+	}
+
+	// Rotation of angle radians around axis, counter clockwise when looking down the axis
+	static void CreateRotationMatrix(Matrix4& rotationMatrix, const vec3<Type>& axis, float angle)
+	{
+		Type length = (Type)sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+		Type x = axis.x / length;
+		Type y = axis.y / length;
+		Type z = axis.z / length;
+
+		Type c = (Type)cos(angle);
+		Type s = (Type)sin(angle);
+		Type t = 1 - c;
+
+		rotationMatrix = IDENTITY;
+
+		// Transpose of the usual column vector form
+		rotationMatrix[0] = c + x * x * t;
+		rotationMatrix[1] = y * x * t + z * s;
+		rotationMatrix[2] = z * x * t - y * s;
+
+		rotationMatrix[4] = x * y * t - z * s;
+		rotationMatrix[5] = c + y * y * t;
+		rotationMatrix[6] = z * y * t + x * s;
+
+		rotationMatrix[8] = x * z * t + y * s;
+		rotationMatrix[9] = y * z * t - x * s;
+		rotationMatrix[10] = c + z * z * t;
 	}
 
 	static const Matrix4 ZERO;
 	static const Matrix4 IDENTITY;
+
+private:
+	// sqrt can't be evaluated in constant expressions, Newton steps from above stop once they no longer decrease
+	static constexpr Type Sqrt(Type value)
+	{
+		if (value <= 0)
+			return 0;
+
+		Type estimate = value > 1 ? value : 1;
+		for (int i = 0; i < 256; ++i)
+		{
+			Type next = (estimate + value / estimate) / 2;
+			if (next >= estimate)
+				break;
+
+			estimate = next;
+		}
+
+		return estimate;
+	}
 };
 
+template <class Type>
+constexpr Matrix4<Type> Matrix4<Type>::ZERO = Matrix4<Type>();
+
+template <class Type>
+constexpr Matrix4<Type> Matrix4<Type>::IDENTITY = Matrix4<Type>(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+
+static_assert(std::is_trivially_copyable<Matrix4<float>>::value, "Matrix4 is copied as plain memory");
+
+
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+
+// Indexed triangle mesh, three indices per triangle
+struct Mesh
+{
+	std::vector<vec3f> positions;
+	std::vector<vec3f> colors;
+	std::vector<uint32_t> indices;
+
+	size_t GetTriangleCount() const
+	{
+		return indices.size() / 3;
+	}
+};
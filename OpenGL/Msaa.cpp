@@ -0,0 +1,184 @@
+#include "Msaa.h"
+#include "Rasterizer.h"
+#include "Kernels.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+// Standard sample positions in 1/16 of a pixel
+static const float PATTERN_2X[2][2] =
+{
+    { 4 / 16.f,  4 / 16.f }, { -4 / 16.f, -4 / 16.f }
+};
+
+static const float PATTERN_4X[4][2] =
+{
+    { -2 / 16.f, -6 / 16.f }, { 6 / 16.f, -2 / 16.f }, { -6 / 16.f, 2 / 16.f }, { 2 / 16.f, 6 / 16.f }
+};
+
+static const float PATTERN_8X[8][2] =
+{
+    { 1 / 16.f, -3 / 16.f }, { -1 / 16.f, 3 / 16.f }, { 5 / 16.f, 1 / 16.f }, { -3 / 16.f, -5 / 16.f },
+    { -5 / 16.f, 5 / 16.f }, { -7 / 16.f, -1 / 16.f }, { 3 / 16.f, 7 / 16.f }, { 7 / 16.f, -7 / 16.f }
+};
+
+static uint32_t PackColor(const TGAColor& color)
+{
+    uint32_t packed;
+    memcpy(&packed, color.bgra, sizeof(packed));
+    return packed;
+}
+
+MsaaTarget::MsaaTarget(int width, int height, int sampleCount)
+    : width(width), height(height), sampleCount(sampleCount),
+    pixels(width * height, 0), sampleBlocks(width * height, -1)
+{
+    if (sampleCount <= 2)
+    {
+        this->sampleCount = 2;
+        pattern = PATTERN_2X;
+    }
+    else if (sampleCount <= 4)
+    {
+        this->sampleCount = 4;
+        pattern = PATTERN_4X;
+    }
+    else
+    {
+        this->sampleCount = 8;
+        pattern = PATTERN_8X;
+    }
+
+    fullMask = (1u << this->sampleCount) - 1;
+}
+
+void MsaaTarget::Clear(const TGAColor& color)
+{
+    fill(pixels.begin(), pixels.end(), PackColor(color));
+    fill(sampleBlocks.begin(), sampleBlocks.end(), -1);
+    samples.clear();
+    freeBlocks.clear();
+}
+
+size_t MsaaTarget::GetExpandedPixelCount() const
+{
+    return samples.size() / sampleCount - freeBlocks.size();
+}
+
+void MsaaTarget::WriteSamples(int pixel, uint32_t mask, uint32_t color)
+{
+    int32_t& block = sampleBlocks[pixel];
+
+    // Fully covered pixels go back to (or stay in) the compressed form
+    if (mask == fullMask)
+    {
+        if (block >= 0)
+        {
+            freeBlocks.push_back(block);
+            block = -1;
+        }
+
+        pixels[pixel] = color;
+        return;
+    }
+
+    // Expand to per sample storage, every sample starts with the old pixel color
+    if (block < 0)
+    {
+        if (!freeBlocks.empty())
+        {
+            block = freeBlocks.back();
+            freeBlocks.pop_back();
+        }
+        else
+        {
+            block = (int32_t)samples.size();
+            samples.resize(samples.size() + sampleCount);
+        }
+
+        fill(samples.begin() + block, samples.begin() + block + sampleCount, pixels[pixel]);
+    }
+
+    for (int i = 0; i < sampleCount; ++i)
+    {
+        if (mask & (1u << i))
+            samples[block + i] = color;
+    }
+}
+
+void MsaaTarget::DrawTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2)
+{
+    // Samples lie up to half a pixel away from the pixel sample point
+    int minX = max(0, (int)floorf(min(v0.x, min(v1.x, v2.x)) - 0.5f));
+    int minY = max(0, (int)floorf(min(v0.y, min(v1.y, v2.y)) - 0.5f));
+    int maxX = min(width - 1, (int)floorf(max(v0.x, max(v1.x, v2.x)) + 0.5f));
+    int maxY = min(height - 1, (int)floorf(max(v0.y, max(v1.y, v2.y)) + 0.5f));
+
+    TriangleSetup setup = SetupTriangle(v0, v1, v2, c0, c1, c2);
+
+    if (setup.area == 0)
+        return;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            // Coverage per sample
+            uint32_t mask = 0;
+            int firstSample = -1;
+
+            for (int i = 0; i < sampleCount; ++i)
+            {
+                float u, s, t;
+                EdgeWeights(setup, x + pattern[i][0], y + pattern[i][1], u, s, t);
+
+                if (u <= 0 && s <= 0 && t <= 0)
+                {
+                    mask |= 1u << i;
+
+                    if (firstSample < 0)
+                        firstSample = i;
+                }
+            }
+
+            if (mask == 0)
+                continue;
+
+            // Shade once per pixel, at the pixel sample point if it is inside the triangle
+            // otherwise at the first covered sample so the attributes are not extrapolated
+            float u, s, t;
+            EdgeWeights(setup, (float)x, (float)y, u, s, t);
+
+            float shadeX = (float)x;
+            float shadeY = (float)y;
+            if (!(u <= 0 && s <= 0 && t <= 0))
+            {
+                shadeX += pattern[firstSample][0];
+                shadeY += pattern[firstSample][1];
+            }
+
+            TGAColor color = ShadeFragment(setup, shadeX, shadeY);
+            WriteSamples(x + y * width, mask, PackColor(color));
+        }
+    }
+}
+
+void MsaaTarget::Resolve(TGAImage& image) const
+{
+    const int bytespp = image.get_bytespp();
+    const int resolveWidth = min(width, image.get_width());
+    const int resolveHeight = min(height, image.get_height());
+    uint8_t* buffer = image.buffer();
+
+    // A row at a time through the kernels of the running CPU
+    const Kernels& kernels = GetKernels();
+
+    for (int y = 0; y < resolveHeight; ++y)
+    {
+        const size_t rowStart = (size_t)y * width;
+        uint8_t* row = buffer + (size_t)y * image.get_width() * bytespp;
+
+        kernels.ResolveSpan(&pixels[rowStart], &sampleBlocks[rowStart], samples.data(), sampleCount, resolveWidth, bytespp, row);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "tgaimage.h"
+
+/*
+	Multisampled color target.
+
+	Coverage is tested for every sample but the triangle is shaded once per pixel.
+	Pixels where all samples hold the same color are stored compressed as a single
+	color, only pixels crossed by an edge get a block of per sample colors.
+	Resolve averages the samples into a regular TGAImage.
+*/
+class MsaaTarget
+{
+public:
+	// sampleCount is 2, 4 or 8
+	MsaaTarget(int width, int height, int sampleCount);
+
+	void Clear(const TGAColor& color);
+	void DrawTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2);
+	void Resolve(TGAImage& image) const;
+
+	int GetWidth() const
+	{
+		return width;
+	}
+
+	int GetHeight() const
+	{
+		return height;
+	}
+
+	int GetSampleCount() const
+	{
+		return sampleCount;
+	}
+
+	// Number of pixels currently holding per sample colors
+	size_t GetExpandedPixelCount() const;
+
+private:
+	void WriteSamples(int pixel, uint32_t mask, uint32_t color);
+
+	int width, height;
+	int sampleCount;
+	uint32_t fullMask;
+
+	// Sample offsets from the pixel sample point
+	const float (*pattern)[2];
+
+	std::vector<uint32_t> pixels;		// BGRA color of compressed pixels
+	std::vector<int32_t> sampleBlocks;	// -1 for compressed pixels, otherwise the first sample in samples
+	std::vector<uint32_t> samples;		// BGRA color of each sample of the expanded pixels
+	std::vector<int32_t> freeBlocks;	// Sample blocks released by pixels that got compressed again
+};
@@ -0,0 +1,127 @@
+#include "OcclusionBuffer.h"
+#include "Kernels.h"
+#include "Pipeline.h"
+#include <algorithm>
+#include <cmath>
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width(width), height(height), depth((size_t)width * height, 1.0f)
+{
+}
+
+void OcclusionBuffer::Clear()
+{
+    std::fill(depth.begin(), depth.end(), 1.0f);
+}
+
+void OcclusionBuffer::AddOccluder(const Mesh& mesh, const mat4f& modelViewProjection)
+{
+    triangles.Clear();
+    ProcessGeometry(geometry, mesh, modelViewProjection, (float)width, (float)height, triangles);
+
+    for (size_t i = 0; i < triangles.Size(); ++i)
+        DrawTriangle(triangles.GetVertex(i, 0), triangles.GetVertex(i, 1), triangles.GetVertex(i, 2));
+}
+
+void OcclusionBuffer::DrawTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2)
+{
+    // Edge function of v1 to v2 at v0, the inside is where all three are negative
+    const float winding = (v0.x - v1.x) * (v2.y - v1.y) - (v0.y - v1.y) * (v2.x - v1.x);
+    if (winding == 0)
+        return;
+
+    const vec4f& a = v0;
+    const vec4f& b = winding < 0 ? v1 : v2;
+    const vec4f& c = winding < 0 ? v2 : v1;
+
+    DepthSetup setup;
+    setup.x0 = a.x, setup.y0 = a.y;
+    setup.x1 = b.x, setup.y1 = b.y;
+    setup.x2 = c.x, setup.y2 = c.y;
+
+    // Largest growth of each edge function within half a pixel of the sample
+    setup.edgeOffset0 = 0.5f * (std::abs(c.y - b.y) + std::abs(c.x - b.x));
+    setup.edgeOffset1 = 0.5f * (std::abs(a.y - c.y) + std::abs(a.x - c.x));
+    setup.edgeOffset2 = 0.5f * (std::abs(b.y - a.y) + std::abs(b.x - a.x));
+
+    // Plane through the three depths, moved back to the farthest depth over the pixel
+    const float determinant = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    setup.depthX = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / determinant;
+    setup.depthY = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / determinant;
+    setup.depthOffset = a.z - setup.depthX * a.x - setup.depthY * a.y + 0.5f * (std::abs(setup.depthX) + std::abs(setup.depthY));
+
+    // Pixels whose square is inside the bounds of the triangle, the others can't be covered entirely
+    const int minX = std::max(0, (int)std::ceil(std::min(a.x, std::min(b.x, c.x)) + 0.5f));
+    const int minY = std::max(0, (int)std::ceil(std::min(a.y, std::min(b.y, c.y)) + 0.5f));
+    const int maxX = std::min(width - 1, (int)std::floor(std::max(a.x, std::max(b.x, c.x)) - 0.5f));
+    const int maxY = std::min(height - 1, (int)std::floor(std::max(a.y, std::max(b.y, c.y)) - 0.5f));
+
+    const Kernels& kernels = GetKernels();
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int spanX = minX; spanX <= maxX; spanX += SPAN_SIZE)
+        {
+            int count = std::min(SPAN_SIZE, maxX - spanX + 1);
+            kernels.DepthSpan(setup, y, spanX, count, &depth[(size_t)y * width + spanX]);
+        }
+    }
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& box, const mat4f& modelViewProjection) const
+{
+    float minX = (float)width, minY = (float)height;
+    float maxX = -1, maxY = -1;
+    float nearest = 1;
+
+    // Corners from the min corner and the rows of the matrix scaled by the size, row vectors multiply row by row
+    const vec3f size = box.max - box.min;
+    const vec4f base = modelViewProjection * vec4f(box.min);
+    const vec4f stepX = modelViewProjection.GetRow(0) * size.x;
+    const vec4f stepY = modelViewProjection.GetRow(1) * size.y;
+    const vec4f stepZ = modelViewProjection.GetRow(2) * size.z;
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        vec4f clip = base;
+        if (corner & 1)
+            clip = clip + stepX;
+        if (corner & 2)
+            clip = clip + stepY;
+        if (corner & 4)
+            clip = clip + stepZ;
+
+        // In front of the near plane, the box reaches the camera
+        if (clip.z < -clip.w || clip.w <= 0)
+            return true;
+
+        vec4f raster = ConvertToRaster(clip, (float)width, (float)height);
+
+        minX = std::min(minX, raster.x);
+        minY = std::min(minY, raster.y);
+        maxX = std::max(maxX, raster.x);
+        maxY = std::max(maxY, raster.y);
+        nearest = std::min(nearest, raster.z);
+    }
+
+    // Every pixel whose square the box touches
+    const int firstX = std::max(0, (int)std::ceil(minX - 0.5f));
+    const int firstY = std::max(0, (int)std::ceil(minY - 0.5f));
+    const int lastX = std::min(width - 1, (int)std::floor(maxX + 0.5f));
+    const int lastY = std::min(height - 1, (int)std::floor(maxY + 0.5f));
+
+    for (int y = firstY; y <= lastY; ++y)
+    {
+        const float* row = &depth[(size_t)y * width];
+
+        // No early out inside the row so the loop vectorizes
+        bool visible = false;
+        for (int x = firstX; x <= lastX; ++x)
+            visible |= row[x] >= nearest;
+
+        if (visible)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Bounds.h"
+#include "TriangleBatch.h"
+#include "Pipeline.h"
+
+// Depth only triangle for the DepthSpan kernel, raster space of the occlusion buffer
+struct DepthSetup
+{
+	float x0, y0, x1, y1, x2, y2;
+
+	// Added to the edge functions so only pixels the triangle covers entirely pass
+	float edgeOffset0, edgeOffset1, edgeOffset2;
+
+	// depth = depthX * x + depthY * y + depthOffset, the farthest depth of the triangle over the pixel
+	float depthX, depthY, depthOffset;
+};
+
+/*
+	Low resolution depth buffer of a few large occluders, walls, buildings and terrain, so objects hidden behind
+	them are rejected from their bounding box before any of their vertices is transformed.
+
+	Occluders go through the usual geometry stage at the resolution of the buffer and are rasterized depth only
+	by the DepthSpan kernel, the edge functions of DrawTriangleBC without the shading. Both sides err towards
+	visible: an occluder only writes the pixels it covers entirely, with its farthest depth over the pixel, and
+	a box is tested over every pixel it touches with its nearest depth. An object is never rejected when a
+	full resolution render would show a sample of it.
+
+	The depths are the 0 (near) to 1 (far) ones of ConvertToRaster.
+*/
+class OcclusionBuffer
+{
+public:
+	static const int DEFAULT_WIDTH = 256;
+	static const int DEFAULT_HEIGHT = 128;
+
+	OcclusionBuffer(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+	// Every pixel back at the far plane
+	void Clear();
+
+	// Draws the triangles of mesh facing the camera, modelViewProjection is the one the mesh is rendered with
+	void AddOccluder(const Mesh& mesh, const mat4f& modelViewProjection);
+
+	// Raster space triangle of the buffer resolution, either winding
+	void DrawTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2);
+
+	// False when the object inside box, drawn with modelViewProjection, is behind the occluders everywhere
+	bool IsVisible(const AABB& box, const mat4f& modelViewProjection) const;
+
+	int GetWidth() const
+	{
+		return width;
+	}
+
+	int GetHeight() const
+	{
+		return height;
+	}
+
+	float GetDepth(int x, int y) const
+	{
+		return depth[y * width + x];
+	}
+
+private:
+	int width, height;
+	std::vector<float> depth;
+	GeometryContext geometry;
+	TriangleBatch triangles;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cmath>
+#include <type_traits>
+#include "Vector.h"
+#include "Matrix4.h"
+#include "AffineMatrix4.h"
+
+/*
+	The matrix Matrix4::Projection builds, keeping only its six terms that are not constant
+
+	|	xScale	0		0		0	|
+	|	0		yScale	0		0	|
+	|	xOffset	yOffset	zScale	-1	|
+	|	0		0		zOffset	0	|
+
+	A vertex costs 6 multiplies instead of 16, and a model view matrix times the projection only has to
+	compute the columns the projection mixes.
+*/
+template <class Type>
+class PerspectiveMatrix
+{
+public:
+	Type xScale, xOffset;
+	Type yScale, yOffset;
+	Type zScale, zOffset;
+
+public:
+	constexpr PerspectiveMatrix()
+		: xScale(0), xOffset(0), yScale(0), yOffset(0), zScale(0), zOffset(0)
+	{}
+
+	// Frustum given by its sides on the near plane, the camera looks down -z
+	constexpr PerspectiveMatrix(float right, float left, float top, float bottom, float near, float far)
+		: xScale((2 * near) / (right - left)), xOffset(-((right + left) / (right - left))),
+		yScale((2 * near) / (top - bottom)), yOffset(-((top + bottom) / (top - bottom))),
+		zScale(-((far + near) / (far - near))), zOffset(-((2 * far * near) / (far - near)))
+	{}
+
+	// Symmetric frustum of fieldOfView radians vertically, tan keeps it out of constant expressions
+	static PerspectiveMatrix FromFieldOfView(float fieldOfView, float aspect, float near, float far)
+	{
+		float top = (float)tan(fieldOfView / 2) * near;
+		float right = top * aspect;
+
+		return PerspectiveMatrix(right, -right, top, -top, near, far);
+	}
+
+	// Same elements as Matrix4::Projection of the same frustum
+	constexpr Matrix4<Type> ToMatrix4() const
+	{
+		return Matrix4<Type>(xScale, 0, 0, 0,
+			0, yScale, 0, 0,
+			xOffset, yOffset, zScale, -1,
+			0, 0, zOffset, 0);
+	}
+
+	// Same as Matrix4 * vec4 on the full matrix
+	constexpr vec4<Type> operator * (const vec4<Type>& vector) const
+	{
+		return vec4<Type>(vector.x * xScale + vector.z * xOffset,
+			vector.y * yScale + vector.z * yOffset,
+			vector.z * zScale + vector.w * zOffset,
+			-vector.z);
+	}
+
+	/*
+		Clip space back to view space, solved from the four rows of the product
+
+		|	1/xs	0		0		0		|
+		|	0		1/ys	0		0		|
+		|	0		0		0		1/zo	|
+		|	xo/xs	yo/ys	-1		zs/zo	|
+	*/
+	constexpr Matrix4<Type> Inverse() const
+	{
+		return Matrix4<Type>(1 / xScale, 0, 0, 0,
+			0, 1 / yScale, 0, 0,
+			0, 0, 0, 1 / zOffset,
+			xOffset / xScale, yOffset / yScale, -1, zScale / zOffset);
+	}
+};
+
+/*
+	Model view matrix then projection, the rows of the affine matrix only meet the non zero terms
+
+	row (a0, a1, a2, a3)  ->  (a0 * xs + a2 * xo, a1 * ys + a2 * yo, a2 * zs + a3 * zo, -a2)
+*/
+template <class Type>
+constexpr Matrix4<Type> operator * (const AffineMatrix4<Type>& modelView, const PerspectiveMatrix<Type>& projection)
+{
+	Matrix4<Type> result;
+
+	for (int row = 0; row < 4; ++row)
+	{
+		const Type a0 = modelView.Get(row, 0);
+		const Type a1 = modelView.Get(row, 1);
+		const Type a2 = modelView.Get(row, 2);
+
+		result[row * 4 + 0] = a0 * projection.xScale + a2 * projection.xOffset;
+		result[row * 4 + 1] = a1 * projection.yScale + a2 * projection.yOffset;
+		result[row * 4 + 2] = a2 * projection.zScale;
+		result[row * 4 + 3] = -a2;
+	}
+
+	// Only the translation row has a3 = 1
+	result[14] += projection.zOffset;
+
+	return result;
+}
+
+static_assert(std::is_trivially_copyable<PerspectiveMatrix<float>>::value, "PerspectiveMatrix is copied as plain memory");
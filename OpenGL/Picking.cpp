@@ -0,0 +1,111 @@
+#include "Picking.h"
+#include <cfloat>
+#include <cmath>
+
+Ray GetRasterRay(const mat4f& matrix, float x, float y, float width, float height)
+{
+    // Inverse of the mapping of ConvertToRaster
+    const float ndcX = x / (0.5f * width) - 1;
+    const float ndcY = 1 - y / (0.5f * height);
+
+    const mat4f inverse = matrix.Inverse();
+
+    vec4f nearPoint = inverse * vec4f(ndcX, ndcY, -1, 1);
+    vec4f farPoint = inverse * vec4f(ndcX, ndcY, 1, 1);
+
+    const vec3f origin(nearPoint.x / nearPoint.w, nearPoint.y / nearPoint.w, nearPoint.z / nearPoint.w);
+    const vec3f target(farPoint.x / farPoint.w, farPoint.y / farPoint.w, farPoint.z / farPoint.w);
+
+    return Ray(origin, (target - origin).Normalized());
+}
+
+bool IntersectRayTriangle(const Ray& ray, const vec3f& v0, const vec3f& v1, const vec3f& v2, float maxDistance,
+    float& distance, float& u, float& v)
+{
+    const vec3f edge1 = v1 - v0;
+    const vec3f edge2 = v2 - v0;
+
+    const vec3f p = vec3f::Cross(ray.direction, edge2);
+    const float determinant = edge1.Dot(p);
+
+    // Parallel to the plane of the triangle, or a degenerate triangle
+    if (std::abs(determinant) < FLT_EPSILON * FLT_EPSILON)
+        return false;
+
+    const float inverseDeterminant = 1 / determinant;
+    const vec3f offset = ray.origin - v0;
+
+    u = offset.Dot(p) * inverseDeterminant;
+    if (u < 0 || u > 1)
+        return false;
+
+    const vec3f q = vec3f::Cross(offset, edge1);
+
+    v = ray.direction.Dot(q) * inverseDeterminant;
+    if (v < 0 || u + v > 1)
+        return false;
+
+    distance = edge2.Dot(q) * inverseDeterminant;
+
+    return distance >= 0 && distance < maxDistance;
+}
+
+MeshPicker::MeshPicker(const Mesh& mesh)
+    : mesh(mesh)
+{
+    ComputeTriangleBounds();
+    bvh.Build(triangleBounds);
+}
+
+void MeshPicker::Refit()
+{
+    ComputeTriangleBounds();
+    bvh.Refit(triangleBounds);
+}
+
+bool MeshPicker::Pick(const Ray& ray, PickHit& hit) const
+{
+    float closest = FLT_MAX;
+    float hitU = 0, hitV = 0;
+
+    auto intersect = [&](uint32_t triangle, const Ray& ray, float& maxDistance)
+    {
+        const vec3f& v0 = mesh.positions[mesh.indices[triangle * 3 + 0]];
+        const vec3f& v1 = mesh.positions[mesh.indices[triangle * 3 + 1]];
+        const vec3f& v2 = mesh.positions[mesh.indices[triangle * 3 + 2]];
+
+        float distance, u, v;
+        if (!IntersectRayTriangle(ray, v0, v1, v2, maxDistance, distance, u, v))
+            return false;
+
+        maxDistance = distance;
+        hitU = u;
+        hitV = v;
+
+        return true;
+    };
+
+    uint32_t triangle = bvh.Raycast(ray, closest, intersect);
+    if (triangle == UINT32_MAX)
+        return false;
+
+    hit.triangle = triangle;
+    hit.distance = closest;
+    hit.weights = vec3f(1 - hitU - hitV, hitU, hitV);
+
+    return true;
+}
+
+void MeshPicker::ComputeTriangleBounds()
+{
+    triangleBounds.resize(mesh.GetTriangleCount());
+
+    for (size_t triangle = 0; triangle < triangleBounds.size(); ++triangle)
+    {
+        AABB bounds;
+        for (int corner = 0; corner < 3; ++corner)
+            bounds.Add(mesh.positions[mesh.indices[triangle * 3 + corner]]);
+
+        triangleBounds[triangle] = bounds;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Bvh.h"
+
+/*
+	Ray from the near plane through raster position (x, y) of a width x height image, in the space matrix takes
+	its vectors from: model space for a model view projection matrix. The raster positions are the ones of
+	ConvertToRaster, the rasterizer samples pixel (x, y) at those integer coordinates. The direction is unit length
+*/
+Ray GetRasterRay(const mat4f& matrix, float x, float y, float width, float height);
+
+// Moller Trumbore, both sides of the triangle are hit. u and v are the weights of v1 and v2 at the hit
+bool IntersectRayTriangle(const Ray& ray, const vec3f& v0, const vec3f& v1, const vec3f& v2, float maxDistance,
+	float& distance, float& u, float& v);
+
+struct PickHit
+{
+	uint32_t triangle;
+	float distance;
+	vec3f weights;		// Barycentric weights of the three vertices at the hit
+};
+
+/*
+	Closest triangle of a mesh under a ray, through a Bvh of the triangle boxes instead of testing every triangle.
+	The mesh has to outlive the picker, Refit after its positions change.
+*/
+class MeshPicker
+{
+public:
+	explicit MeshPicker(const Mesh& mesh);
+
+	// Positions moved, the triangles are the same
+	void Refit();
+
+	// False when the ray misses every triangle
+	bool Pick(const Ray& ray, PickHit& hit) const;
+
+	const Bvh& GetBvh() const
+	{
+		return bvh;
+	}
+
+private:
+	void ComputeTriangleBounds();
+
+	const Mesh& mesh;
+	std::vector<AABB> triangleBounds;
+	Bvh bvh;
+};
@@ -0,0 +1,480 @@
+#include "Pipeline.h"
+#include "Clipper.h"
+#include "Rasterizer.h"
+#include "Profiler.h"
+#include "Kernels.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "OcclusionBuffer.h"
+#include <algorithm>
+
+// Work split of the parallel stages
+const size_t VERTEX_GRAIN = 1024;
+const size_t TRIANGLE_GRAIN = 256;
+const size_t INSTANCE_GRAIN = 16;
+
+// Number of 32 bit triangle ids and instance indices
+const uint64_t MAX_INSTANCE_IDS = (uint64_t)UINT32_MAX + 1;
+
+vec4f ConvertToRaster(const vec4f& clipVertex, float width, float height)
+{
+    // Perspective division
+    vec4f ndcVertex = clipVertex;
+    ndcVertex.x = clipVertex.x / clipVertex.w;
+    ndcVertex.y = clipVertex.y / clipVertex.w;
+    ndcVertex.z = clipVertex.z / clipVertex.w;
+
+    ndcVertex.x = (ndcVertex.x + 1) * 0.5f * width; // 0-widht range
+
+    // in raster space Y is down, top left corner of the screen is (0, 0)
+    ndcVertex.y = (1 - ndcVertex.y) * 0.5f * height; // 0-height range
+    ndcVertex.z = (ndcVertex.z + 1) * 0.5f;         // 0-1 range
+
+    return ndcVertex;
+}
+
+void ConvertToRaster(TriangleBatch& triangles, float width, float height)
+{
+    const size_t count = triangles.Size();
+
+    // Same operations as the vertex version, one array at a time
+    for (int slot = 0; slot < 3; ++slot)
+    {
+        float* x = triangles.Get(TriangleBatch::X, slot);
+        float* y = triangles.Get(TriangleBatch::Y, slot);
+        float* z = triangles.Get(TriangleBatch::Z, slot);
+        const float* w = triangles.Get(TriangleBatch::W, slot);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            x[i] = (x[i] / w[i] + 1) * 0.5f * width;
+            y[i] = (1 - y[i] / w[i]) * 0.5f * height;
+            z[i] = (z[i] / w[i] + 1) * 0.5f;
+        }
+    }
+}
+
+namespace
+{
+    // Triangles begin to end of the mesh with their clip space vertices, the ids are the triangle indices
+    void AssembleTriangles(const Mesh& mesh, const std::vector<vec4f>& clipVertices, size_t begin, size_t end, TriangleBatch& out)
+    {
+        out.Resize(end - begin);
+
+        for (int slot = 0; slot < 3; ++slot)
+        {
+            float* x = out.Get(TriangleBatch::X, slot);
+            float* y = out.Get(TriangleBatch::Y, slot);
+            float* z = out.Get(TriangleBatch::Z, slot);
+            float* w = out.Get(TriangleBatch::W, slot);
+            float* r = out.Get(TriangleBatch::R, slot);
+            float* g = out.Get(TriangleBatch::G, slot);
+            float* b = out.Get(TriangleBatch::B, slot);
+
+            // Without vertex colors the slots get the red, green and blue of the Triangle constructor
+            const vec3f defaultColor(slot == 0 ? 1.0f : 0.0f, slot == 1 ? 1.0f : 0.0f, slot == 2 ? 1.0f : 0.0f);
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const uint32_t vertex = mesh.indices[i * 3 + slot];
+                const vec4f& position = clipVertices[vertex];
+                const vec3f& color = mesh.colors.empty() ? defaultColor : mesh.colors[vertex];
+
+                x[i - begin] = position.x;
+                y[i - begin] = position.y;
+                z[i - begin] = position.z;
+                w[i - begin] = position.w;
+                r[i - begin] = color.x;
+                g[i - begin] = color.y;
+                b[i - begin] = color.z;
+            }
+        }
+
+        uint32_t* ids = out.GetIds();
+        for (size_t i = begin; i < end; ++i)
+            ids[i - begin] = (uint32_t)i;
+    }
+
+    // Clips, converts and culls triangles begin to end of the mesh, the raster space triangles are left in batches.clipped
+    void ProcessTriangles(const Mesh& mesh, const std::vector<vec4f>& clipVertices, size_t begin, size_t end, float width, float height,
+        GeometryBatches& batches)
+    {
+        AssembleTriangles(mesh, clipVertices, begin, end, batches.assembled);
+
+        batches.clipped.Clear();
+        batches.clipper.Clip(batches.assembled, batches.clipped);
+
+        ConvertToRaster(batches.clipped, width, height);
+        CullTriangles(batches.clipped, width, height);
+    }
+
+    static_assert(sizeof(affine4f) == 12 * sizeof(float), "ComposeMatrices reads the instances as arrays of floats");
+
+    // Model view projections of the instances in the kernel layout, 16 floats each, in context.matrices and the instances
+    // that can be visible in order in context.visible
+    void CullInstances(GeometryContext& context, const Mesh& mesh, const affine4f* instances, size_t instanceCount,
+        const mat4f& viewProjection, const OcclusionBuffer* occlusion)
+    {
+        PROFILE_SCOPE("cull instances");
+
+        float matrix[16];
+        GetKernelMatrix(viewProjection, matrix);
+
+        std::vector<float>& matrices = context.matrices;
+        matrices.resize(instanceCount * 16);
+        GetKernels().ComposeMatrices(matrix, reinterpret_cast<const float*>(instances), instanceCount, matrices.data());
+
+        const AABB box = ComputeBounds(mesh.positions);
+        const BoundingSphere sphere = ComputeBoundingSphere(mesh.positions);
+
+        BoundsBatch& bounds = context.bounds;
+        bounds.Clear();
+        for (size_t instance = 0; instance < instanceCount; ++instance)
+            bounds.Add(box.Transformed(instances[instance]), sphere.Transformed(instances[instance]));
+
+        std::vector<uint32_t>& visible = context.visible;
+        visible.clear();
+        CullBounds(Frustum(viewProjection), bounds, visible);
+
+        if (!occlusion)
+            return;
+
+        // The model box with the whole matrix, tighter than the world box around it
+        size_t kept = 0;
+        for (uint32_t instance : visible)
+        {
+            mat4f modelViewProjection;
+            for (int i = 0; i < 16; ++i)
+                modelViewProjection[i] = matrices[(size_t)instance * 16 + i];
+
+            if (occlusion->IsVisible(box, modelViewProjection))
+                visible[kept++] = instance;
+        }
+
+        visible.resize(kept);
+    }
+}
+
+void ProcessGeometry(GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, float width, float height,
+    TriangleBatch& outTriangles)
+{
+    PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, mesh.GetTriangleCount());
+
+    // Transform every vertex once, indices share them between triangles
+    std::vector<vec4f>& clipVertices = context.clipVertices;
+    clipVertices.resize(mesh.positions.size());
+    {
+        PROFILE_SCOPE("transform");
+
+        float matrix[16];
+        GetKernelMatrix(modelViewProjection, matrix);
+        GetKernels().TransformPositions(matrix, mesh.positions.data(), clipVertices.data(), mesh.positions.size());
+    }
+
+    PROFILE_SCOPE("clip");
+
+    context.Reserve(1);
+    GeometryBatches& batches = context.threads[0];
+    ProcessTriangles(mesh, clipVertices, 0, mesh.GetTriangleCount(), width, height, batches);
+
+    outTriangles.Append(batches.clipped);
+}
+
+void ProcessGeometry(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, float width, float height,
+    TriangleBatch& outTriangles)
+{
+    std::vector<vec4f>& clipVertices = context.clipVertices;
+    clipVertices.resize(mesh.positions.size());
+
+    PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, mesh.GetTriangleCount());
+
+    float matrix[16];
+    GetKernelMatrix(modelViewProjection, matrix);
+
+    jobs.ParallelFor(0, mesh.positions.size(), VERTEX_GRAIN, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("transform");
+
+        GetKernels().TransformPositions(matrix, mesh.positions.data() + begin, clipVertices.data() + begin, end - begin);
+    });
+
+    // Every range of triangles writes its own output, putting them back together in range order keeps the submission order
+    const size_t triangleCount = mesh.GetTriangleCount();
+    const size_t rangeCount = (triangleCount + TRIANGLE_GRAIN - 1) / TRIANGLE_GRAIN;
+
+    if (context.ranges.size() < rangeCount)
+        context.ranges.resize(rangeCount);
+
+    context.Reserve(jobs.GetThreadCount());
+
+    jobs.ParallelFor(0, triangleCount, TRIANGLE_GRAIN, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("clip");
+
+        GeometryBatches& batches = context.threads[jobs.GetThreadIndex()];
+
+        ProcessTriangles(mesh, clipVertices, begin, end, width, height, batches);
+
+        TriangleBatch& range = context.ranges[begin / TRIANGLE_GRAIN];
+        range.Clear();
+        range.Append(batches.clipped);
+    });
+
+    for (size_t range = 0; range < rangeCount; ++range)
+        outTriangles.Append(context.ranges[range]);
+}
+
+void ProcessGeometry(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, TileBinner& binner,
+    size_t firstTriangle, const BlendState& blend)
+{
+    const float width = (float)binner.GetWidth();
+    const float height = (float)binner.GetHeight();
+
+    std::vector<vec4f>& clipVertices = context.clipVertices;
+    clipVertices.resize(mesh.positions.size());
+
+    PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, mesh.GetTriangleCount());
+
+    float matrix[16];
+    GetKernelMatrix(modelViewProjection, matrix);
+
+    jobs.ParallelFor(0, mesh.positions.size(), VERTEX_GRAIN, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("transform");
+
+        GetKernels().TransformPositions(matrix, mesh.positions.data() + begin, clipVertices.data() + begin, end - begin);
+    });
+
+    context.Reserve(jobs.GetThreadCount());
+
+    jobs.ParallelFor(0, mesh.GetTriangleCount(), TRIANGLE_GRAIN, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("clip and bin");
+
+        const int thread = jobs.GetThreadIndex();
+        GeometryBatches& batches = context.threads[thread];
+
+        ProcessTriangles(mesh, clipVertices, begin, end, width, height, batches);
+
+        // The ids are mesh triangle indices, the pieces of one triangle are next to each other in clipping order
+        binner.Bin(thread, batches.clipped, firstTriangle, blend);
+    });
+}
+
+size_t ProcessInstances(GeometryContext& context, const Mesh& mesh, const affine4f* instances, size_t instanceCount,
+    const mat4f& viewProjection, float width, float height, TriangleBatch& outTriangles, const OcclusionBuffer* occlusion)
+{
+    const size_t triangleCount = mesh.GetTriangleCount();
+
+    // Every id has to fit in the 32 bits of TriangleBatch, a larger draw is refused in every build
+    if ((uint64_t)instanceCount * triangleCount > MAX_INSTANCE_IDS)
+        return 0;
+
+    CullInstances(context, mesh, instances, instanceCount, viewProjection, occlusion);
+
+    const std::vector<uint32_t>& visible = context.visible;
+    PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, visible.size() * triangleCount);
+
+    PROFILE_SCOPE("instances");
+
+    context.Reserve(1);
+    GeometryBatches& batches = context.threads[0];
+    batches.clipVertices.resize(mesh.positions.size());
+
+    for (uint32_t instance : visible)
+    {
+        GetKernels().TransformPositions(&context.matrices[(size_t)instance * 16], mesh.positions.data(), batches.clipVertices.data(),
+            mesh.positions.size());
+        ProcessTriangles(mesh, batches.clipVertices, 0, triangleCount, width, height, batches);
+
+        const size_t firstId = (size_t)instance * triangleCount;
+        uint32_t* ids = batches.clipped.GetIds();
+        for (size_t i = 0; i < batches.clipped.Size(); ++i)
+            ids[i] = (uint32_t)(firstId + ids[i]);
+
+        outTriangles.Append(batches.clipped);
+    }
+
+    return visible.size();
+}
+
+size_t ProcessInstances(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const affine4f* instances, size_t instanceCount,
+    const mat4f& viewProjection, TileBinner& binner, size_t firstTriangle, const BlendState& blend, const OcclusionBuffer* occlusion)
+{
+    // The culling hands out 32 bit instance indices
+    if ((uint64_t)instanceCount > MAX_INSTANCE_IDS)
+        return 0;
+
+    const float width = (float)binner.GetWidth();
+    const float height = (float)binner.GetHeight();
+
+    CullInstances(context, mesh, instances, instanceCount, viewProjection, occlusion);
+
+    const std::vector<uint32_t>& visible = context.visible;
+    const size_t triangleCount = mesh.GetTriangleCount();
+    PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, visible.size() * triangleCount);
+
+    context.Reserve(jobs.GetThreadCount());
+
+    jobs.ParallelFor(0, visible.size(), INSTANCE_GRAIN, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("instances");
+
+        const int thread = jobs.GetThreadIndex();
+        GeometryBatches& batches = context.threads[thread];
+        batches.clipVertices.resize(mesh.positions.size());
+
+        for (size_t index = begin; index < end; ++index)
+        {
+            const uint32_t instance = visible[index];
+
+            GetKernels().TransformPositions(&context.matrices[(size_t)instance * 16], mesh.positions.data(), batches.clipVertices.data(),
+                mesh.positions.size());
+            ProcessTriangles(mesh, batches.clipVertices, 0, triangleCount, width, height, batches);
+
+            binner.Bin(thread, batches.clipped, firstTriangle + (size_t)instance * triangleCount, blend);
+        }
+    });
+
+    return visible.size();
+}
+
+bool IsTriangleCulled(const Triangle& triangle, float width, float height)
+{
+    const vec4f& v0 = triangle.vertices[0];
+    const vec4f& v1 = triangle.vertices[1];
+    const vec4f& v2 = triangle.vertices[2];
+
+    // The rasterizer only accepts counter clockwise triangles (negative area), the rest never covers a sample
+    float area = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY());
+    if (!(area < 0))
+    {
+        PROFILE_COUNT(Counter::TRIANGLES_CULLED, 1);
+        return true;
+    }
+
+    // No sample inside the bounds
+    float minX = std::min(v0.x, std::min(v1.x, v2.x));
+    float minY = std::min(v0.y, std::min(v1.y, v2.y));
+    float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+    float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+
+    bool outside = maxX < std::max(0.0f, (float)(int)minX) || maxY < std::max(0.0f, (float)(int)minY) || minX >= width || minY >= height;
+
+    if (outside)
+        PROFILE_COUNT(Counter::TRIANGLES_CULLED, 1);
+
+    return outside;
+}
+
+void CullTriangles(TriangleBatch& triangles, float width, float height)
+{
+    const size_t count = triangles.Size();
+
+    std::vector<uint8_t> keep(count);
+
+    const float* x0 = triangles.Get(TriangleBatch::X, 0);
+    const float* y0 = triangles.Get(TriangleBatch::Y, 0);
+    const float* x1 = triangles.Get(TriangleBatch::X, 1);
+    const float* y1 = triangles.Get(TriangleBatch::Y, 1);
+    const float* x2 = triangles.Get(TriangleBatch::X, 2);
+    const float* y2 = triangles.Get(TriangleBatch::Y, 2);
+
+    // Same tests as IsTriangleCulled over the whole arrays, the padding past count is never initialized so it isn't read
+    for (size_t i = 0; i < count; ++i)
+    {
+        float area = (x2[i] - x0[i]) * (y1[i] - y0[i]) - (y2[i] - y0[i]) * (x1[i] - x0[i]);
+
+        float minX = std::min(x0[i], std::min(x1[i], x2[i]));
+        float minY = std::min(y0[i], std::min(y1[i], y2[i]));
+        float maxX = std::max(x0[i], std::max(x1[i], x2[i]));
+        float maxY = std::max(y0[i], std::max(y1[i], y2[i]));
+
+        bool outside = maxX < std::max(0.0f, (float)(int)minX) || maxY < std::max(0.0f, (float)(int)minY) || minX >= width || minY >= height;
+
+        keep[i] = (uint8_t)((area < 0) & !outside);
+    }
+
+    size_t culled = triangles.Compact(keep.data());
+    PROFILE_COUNT(Counter::TRIANGLES_CULLED, culled);
+    (void)culled;
+}
+
+void RasterizeTriangles(TGAImage& image, const TriangleBatch& triangles)
+{
+    PROFILE_SCOPE("raster");
+
+    SmallTriangleBatch smallTriangles(image);
+
+    for (size_t i = 0; i < triangles.Size(); ++i)
+    {
+        const vec4f v0 = triangles.GetVertex(i, 0);
+        const vec4f v1 = triangles.GetVertex(i, 1);
+        const vec4f v2 = triangles.GetVertex(i, 2);
+
+        if (IsSmallTriangle(v0, v1, v2))
+        {
+            smallTriangles.Add(v0, v1, v2, triangles.GetColor(i, 0), triangles.GetColor(i, 1), triangles.GetColor(i, 2));
+        }
+        else
+        {
+            smallTriangles.Flush();
+            DrawTriangleBC(image, v0, v1, v2, triangles.GetColor(i, 0), triangles.GetColor(i, 1), triangles.GetColor(i, 2));
+        }
+    }
+
+    smallTriangles.Flush();
+}
+
+void RasterizeTriangles(JobSystem& jobs, TGAImage& image, const TriangleBatch& triangles)
+{
+    const int tilesX = (image.get_width() + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (image.get_height() + TILE_SIZE - 1) / TILE_SIZE;
+
+    jobs.ParallelFor(0, tilesX * tilesY, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; ++tile)
+        {
+            PROFILE_SCOPE("raster tile");
+
+            ScissorRect rect;
+            rect.minX = (int)(tile % tilesX) * TILE_SIZE;
+            rect.minY = (int)(tile / tilesX) * TILE_SIZE;
+            rect.maxX = std::min(rect.minX + TILE_SIZE, image.get_width()) - 1;
+            rect.maxY = std::min(rect.minY + TILE_SIZE, image.get_height()) - 1;
+
+            // Tiles own their pixels, so the threads never write the same memory
+            SmallTriangleBatch smallTriangles(image, rect);
+
+            const float* x0 = triangles.Get(TriangleBatch::X, 0);
+            const float* y0 = triangles.Get(TriangleBatch::Y, 0);
+            const float* x1 = triangles.Get(TriangleBatch::X, 1);
+            const float* y1 = triangles.Get(TriangleBatch::Y, 1);
+            const float* x2 = triangles.Get(TriangleBatch::X, 2);
+            const float* y2 = triangles.Get(TriangleBatch::Y, 2);
+
+            for (size_t i = 0; i < triangles.Size(); ++i)
+            {
+                if (std::max(x0[i], std::max(x1[i], x2[i])) < rect.minX || std::min(x0[i], std::min(x1[i], x2[i])) >= rect.maxX + 1 ||
+                    std::max(y0[i], std::max(y1[i], y2[i])) < rect.minY || std::min(y0[i], std::min(y1[i], y2[i])) >= rect.maxY + 1)
+                    continue;
+
+                const vec4f v0 = triangles.GetVertex(i, 0);
+                const vec4f v1 = triangles.GetVertex(i, 1);
+                const vec4f v2 = triangles.GetVertex(i, 2);
+
+                if (IsSmallTriangle(v0, v1, v2))
+                {
+                    smallTriangles.Add(v0, v1, v2, triangles.GetColor(i, 0), triangles.GetColor(i, 1), triangles.GetColor(i, 2));
+                }
+                else
+                {
+                    smallTriangles.Flush();
+                    DrawTriangleBC(image, v0, v1, v2, triangles.GetColor(i, 0), triangles.GetColor(i, 1), triangles.GetColor(i, 2), rect);
+                }
+            }
+
+            smallTriangles.Flush();
+        }
+    });
+}
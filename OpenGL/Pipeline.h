@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Triangle.h"
+#include "TriangleBatch.h"
+#include "tgaimage.h"
+#include "JobSystem.h"
+#include "TileBinner.h"
+#include "Clipper.h"
+#include "Bounds.h"
+
+class OcclusionBuffer;
+
+// Size in pixels of the tiles of the tiled rasterizer
+const int TILE_SIZE = 64;
+
+// Perspective division and viewport mapping: x y in pixels, z in the 0-1 range, w is kept for perspective correction
+vec4f ConvertToRaster(const vec4f& clipVertex, float width, float height);
+
+// ConvertToRaster on every vertex of the batch, in place
+void ConvertToRaster(TriangleBatch& triangles, float width, float height);
+
+// Scratch batches of one geometry thread, kept between its ranges and its instances
+struct GeometryBatches
+{
+	std::vector<vec4f> clipVertices;	// Vertices of the instance being drawn
+	TriangleBatch assembled;
+	TriangleBatch clipped;
+	BatchClipper clipper;
+};
+
+/*
+	Scratch memory of the geometry stage. The caller keeps one from frame to frame and the buffers keep their
+	capacity, so once the first frames have grown them the geometry stage allocates nothing. A context is used
+	by one ProcessGeometry or ProcessInstances call at a time.
+*/
+struct GeometryContext
+{
+	std::vector<vec4f> clipVertices;		// Whole mesh transformed once
+	std::vector<GeometryBatches> threads;	// Per JobSystem::GetThreadIndex, 0 for the serial paths
+	std::vector<TriangleBatch> ranges;		// Output of every range of the ordered parallel path
+	std::vector<float> matrices;			// Model view projections of the instances
+	std::vector<uint32_t> visible;			// Instances left by the culling
+	BoundsBatch bounds;
+
+	// Grows threads to threadCount, the batches already there keep their memory
+	void Reserve(size_t threadCount)
+	{
+		if (threads.size() < threadCount)
+			threads.resize(threadCount);
+	}
+};
+
+// Transforms the mesh to clip space, clips it and appends the raster space triangles to outTriangles. The ids of the
+// triangles are the indices of the mesh triangles they come from
+void ProcessGeometry(GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, float width, float height,
+	TriangleBatch& outTriangles);
+
+// Same as ProcessGeometry with the vertices and triangles split over the job system, the triangles come out in the same order
+void ProcessGeometry(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, float width, float height,
+	TriangleBatch& outTriangles);
+
+// Parallel geometry stage feeding the binner, each range of triangles is clipped by one thread into its own bins.
+// The binner has to be Reset for jobs.GetThreadCount() threads at the start of the frame. When binning several
+// meshes in a frame, firstTriangle is the number of triangles submitted before so the sequence numbers keep increasing.
+// The triangles are blended into the image with blend
+void ProcessGeometry(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const mat4f& modelViewProjection, TileBinner& binner,
+	size_t firstTriangle = 0, const BlendState& blend = BlendState());
+
+/*
+	Draws mesh once per model matrix of instances, forests, crowds and particles: many copies of one small mesh.
+
+	The model view projections of every instance are composed in one pass and the instances whose bounds are
+	outside of the frustum of viewProjection, or hidden behind the occluders of occlusion when given, are dropped
+	before any of their vertices is transformed. The others go through the geometry stage one after the other
+	with the same scratch memory, so the positions, colors and indices of the mesh stay in cache. Triangles are
+	drawn in order without a depth test, so the occluders have to be drawn after the instances they hide.
+
+	The ids of the triangles are instance * mesh triangle count + mesh triangle index. When instanceCount
+	times the mesh triangle count is more than 2^32 the ids don't fit, nothing is drawn and 0 is returned.
+	Returns the number of instances drawn
+*/
+size_t ProcessInstances(GeometryContext& context, const Mesh& mesh, const affine4f* instances, size_t instanceCount,
+	const mat4f& viewProjection, float width, float height, TriangleBatch& outTriangles, const OcclusionBuffer* occlusion = nullptr);
+
+// ProcessInstances feeding the binner, the instances are split over the job system. Instance i takes the sequence
+// numbers of the input triangles from firstTriangle + i * mesh triangle count, the draw takes instanceCount times
+// the mesh triangle count of them. The sequence numbers are 64 bits, the only limit is 2^32 instances, nothing is
+// drawn and 0 returned past it
+size_t ProcessInstances(JobSystem& jobs, GeometryContext& context, const Mesh& mesh, const affine4f* instances, size_t instanceCount,
+	const mat4f& viewProjection, TileBinner& binner, size_t firstTriangle = 0, const BlendState& blend = BlendState(),
+	const OcclusionBuffer* occlusion = nullptr);
+
+// True for raster space triangles that cannot cover a sample: back facing, degenerate or outside of the image
+bool IsTriangleCulled(const Triangle& triangle, float width, float height);
+
+// Removes the triangles IsTriangleCulled culls from the batch in one pass over the arrays, the rest keep their order
+void CullTriangles(TriangleBatch& triangles, float width, float height);
+
+// Draws raster space triangles in order, few-pixel triangles go through the small triangle batch
+void RasterizeTriangles(TGAImage& image, const TriangleBatch& triangles);
+
+// Splits the image in tiles drawn in parallel, each tile draws the triangles overlapping it in order
+void RasterizeTriangles(JobSystem& jobs, TGAImage& image, const TriangleBatch& triangles);
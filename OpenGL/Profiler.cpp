@@ -0,0 +1,196 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct TimerEvent
+    {
+        const char* name;
+        Profiler::Clock::time_point start;
+        Profiler::Clock::time_point end;
+    };
+
+    // Everything a thread records, only that thread writes to it
+    struct ThreadData
+    {
+        uint64_t counters[(int)Counter::COUNT] = {};
+        vector<TimerEvent> events;
+        int id = 0;
+    };
+
+    // Thread blocks stay alive until exit so the results survive the threads
+    mutex registryMutex;
+    vector<ThreadData*> registry;
+    Profiler::Clock::time_point origin = Profiler::Clock::now();
+
+    ThreadData& GetThreadData()
+    {
+        thread_local ThreadData* data = nullptr;
+
+        if (!data)
+        {
+            data = new ThreadData();
+
+            lock_guard<mutex> lock(registryMutex);
+            data->id = (int)registry.size();
+            registry.push_back(data);
+        }
+
+        return *data;
+    }
+
+    const char* COUNTER_NAMES[(int)Counter::COUNT] =
+    {
+        "triangles submitted",
+        "triangles culled",
+        "triangles clipped",
+        "triangles rasterized",
+        "pixels tested",
+        "pixels written",
+        "clip positive w",
+        "clip right",
+        "clip left",
+        "clip top",
+        "clip bottom",
+        "clip far",
+        "clip near"
+    };
+
+    double ToMicroseconds(Profiler::Clock::duration duration)
+    {
+        return chrono::duration<double, micro>(duration).count();
+    }
+}
+
+void Profiler::AddCount(Counter counter, uint64_t value)
+{
+    GetThreadData().counters[(int)counter] += value;
+}
+
+uint64_t Profiler::GetCount(Counter counter)
+{
+    lock_guard<mutex> lock(registryMutex);
+
+    uint64_t total = 0;
+    for (const ThreadData* data : registry)
+        total += data->counters[(int)counter];
+
+    return total;
+}
+
+const char* Profiler::GetCounterName(Counter counter)
+{
+    return COUNTER_NAMES[(int)counter];
+}
+
+void Profiler::AddEvent(const char* name, Clock::time_point start, Clock::time_point end)
+{
+    GetThreadData().events.push_back({ name, start, end });
+}
+
+void Profiler::Reset()
+{
+    lock_guard<mutex> lock(registryMutex);
+
+    for (ThreadData* data : registry)
+    {
+        fill(begin(data->counters), end(data->counters), 0);
+        data->events.clear();
+    }
+
+    origin = Clock::now();
+}
+
+void Profiler::PrintSummary(ostream& os)
+{
+    lock_guard<mutex> lock(registryMutex);
+
+    os << "Counters" << endl;
+    for (int i = 0; i < (int)Counter::COUNT; ++i)
+    {
+        uint64_t total = 0;
+        for (const ThreadData* data : registry)
+            total += data->counters[i];
+
+        os << "  " << COUNTER_NAMES[i] << ": " << total << endl;
+    }
+
+    struct TimerTotal
+    {
+        int calls = 0;
+        double totalUs = 0;
+        double maxUs = 0;
+    };
+
+    map<string, TimerTotal> timers;
+    for (const ThreadData* data : registry)
+    {
+        for (const TimerEvent& event : data->events)
+        {
+            double us = ToMicroseconds(event.end - event.start);
+
+            TimerTotal& timer = timers[event.name];
+            ++timer.calls;
+            timer.totalUs += us;
+            timer.maxUs = max(timer.maxUs, us);
+        }
+    }
+
+    os << "Timers (calls, total ms, avg us, max us)" << endl;
+    for (const auto& timer : timers)
+    {
+        os << "  " << timer.first << ": " << timer.second.calls << ", " << timer.second.totalUs / 1000 << ", "
+            << timer.second.totalUs / timer.second.calls << ", " << timer.second.maxUs << endl;
+    }
+}
+
+bool Profiler::WriteChromeTrace(const string& filename)
+{
+    ofstream out(filename);
+    if (!out.is_open())
+    {
+        cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+    for (const ThreadData* data : registry)
+    {
+        for (const TimerEvent& event : data->events)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << data->id
+                << ",\"ts\":" << ToMicroseconds(event.start - origin)
+                << ",\"dur\":" << ToMicroseconds(event.end - event.start) << "}";
+        }
+    }
+
+    out << "\n],\"otherData\":{";
+
+    for (int i = 0; i < (int)Counter::COUNT; ++i)
+    {
+        uint64_t total = 0;
+        for (const ThreadData* data : registry)
+            total += data->counters[i];
+
+        out << (i ? "," : "") << "\"" << COUNTER_NAMES[i] << "\":" << total;
+    }
+
+    out << "}}\n";
+
+    return out.good();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/*
+	Low overhead instrumentation of the pipeline.
+
+	Every thread counts into its own block of counters and records its own timer
+	events, nothing is shared while the frame runs. The blocks are only summed up
+	when the results are printed or exported to a Chrome trace (chrome://tracing).
+
+	Define ENABLE_PROFILING for the whole project to turn it on, otherwise the
+	PROFILE_ macros compile to nothing.
+*/
+
+enum class Counter
+{
+	TRIANGLES_SUBMITTED = 0,
+	TRIANGLES_CULLED,
+	TRIANGLES_CLIPPED,		// Triangles that needed clipping against the planes
+	TRIANGLES_RASTERIZED,
+	PIXELS_TESTED,
+	PIXELS_WRITTEN,
+	CLIP_POSITIVEW,			// Triangles crossing each plane, in the order of the Plane enum
+	CLIP_RIGHT,
+	CLIP_LEFT,
+	CLIP_TOP,
+	CLIP_BOTTOM,
+	CLIP_FAR,
+	CLIP_NEAR,
+	COUNT
+};
+
+namespace Profiler
+{
+	typedef std::chrono::steady_clock Clock;
+
+	void AddCount(Counter counter, uint64_t value);
+	uint64_t GetCount(Counter counter);
+	const char* GetCounterName(Counter counter);
+
+	// Records a finished timer on the calling thread
+	void AddEvent(const char* name, Clock::time_point start, Clock::time_point end);
+
+	// Forgets every counter and event
+	void Reset();
+
+	// Counter totals and per name timer totals
+	void PrintSummary(std::ostream& os);
+
+	// Chrome trace event format, one complete event per timer and the counter totals as metadata
+	bool WriteChromeTrace(const std::string& filename);
+
+	// Times the enclosing scope, name has to outlive the profiler (a string literal)
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(const char* name)
+			: name(name), start(Clock::now())
+		{}
+
+		~ScopedTimer()
+		{
+			AddEvent(name, start, Clock::now());
+		}
+
+	private:
+		const char* name;
+		Clock::time_point start;
+	};
+}
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(name)
+#define PROFILE_COUNT(counter, value) Profiler::AddCount(counter, value)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(counter, value) ((void)0)
+#endif // ENABLE_PROFILING
@@ -0,0 +1,367 @@
+#include "Rasterizer.h"
+#include "Profiler.h"
+#include "Kernels.h"
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+ScissorRect GetImageRect(const TGAImage& image)
+{
+    return { 0, 0, image.get_width() - 1, image.get_height() - 1 };
+}
+
+ScissorRect GetTileRect(const TileBuffer& tile)
+{
+    return { tile.GetMinX(), tile.GetMinY(), tile.GetMinX() + tile.GetWidth() - 1, tile.GetMinY() + tile.GetHeight() - 1 };
+}
+
+void ClearTarget(TGAImage& image, const uint32_t& width, const uint32_t& height, const TGAColor& color)
+{
+	for (uint32_t i = 0; i < width; ++i)
+	{
+		for (uint32_t j = 0; j < height; ++j)
+		{
+			image.set(i, j, color);
+		}
+	}
+}
+
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2)
+{
+    // Red, green and blue corners like the Triangle constructor, through the same setup and span kernels
+    DrawTriangleBC(image, v0, v1, v2, vec3f(1, 0, 0), vec3f(0, 1, 0), vec3f(0, 0, 1));
+}
+
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, vec3f c0, vec3f c1, vec3f c2)
+{
+    DrawTriangleBC(image, v0, v1, v2, c0, c1, c2, GetImageRect(image));
+}
+
+namespace
+{
+    // Shades the rows of the triangle inside the scissor rectangle span by span, writeSpan(y, spanX, count, covered, bgra, coverage)
+    // gets the spans with at least one covered pixel
+    template<class SpanWriter>
+    void ShadeSpans(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2,
+        const ScissorRect& scissor, const SpanWriter& writeSpan)
+    {
+        // Calculate the Min and MaxBounds
+        // Points to Check for
+        vec3f minBounds;
+        minBounds.x = min(v0.x, min(v1.x, v2.x));
+        minBounds.y = min(v0.y, min(v1.y, v2.y));
+
+        vec3f maxBounds;
+        maxBounds.x = max(v0.x, max(v1.x, v2.x));
+        maxBounds.y = max(v0.y, max(v1.y, v2.y));
+
+        // Only the samples inside the scissor rectangle
+        minBounds.x = max(minBounds.x, (float)scissor.minX);
+        minBounds.y = max(minBounds.y, (float)scissor.minY);
+        maxBounds.x = min(maxBounds.x, (float)scissor.maxX);
+        maxBounds.y = min(maxBounds.y, (float)scissor.maxY);
+
+
+        TriangleSetup setup = SetupTriangle(v0, v1, v2, c0, c1, c2);
+
+        // Rows are shaded in spans by the kernels of the running CPU
+        const Kernels& kernels = GetKernels();
+        alignas(64) uint8_t bgra[SPAN_SIZE * 4];
+        alignas(64) uint8_t coverage[SPAN_SIZE];
+
+        int minX = (int)minBounds.x;
+        int maxX = (int)floor(maxBounds.x);
+
+        // Counted locally, the compiler drops them when profiling is off
+        uint64_t pixelsTested = 0;
+        uint64_t pixelsWritten = 0;
+
+        for (int y = minBounds.y; y <= maxBounds.y; ++y)
+        {
+            for (int spanX = minX; spanX <= maxX; spanX += SPAN_SIZE)
+            {
+                int count = min(SPAN_SIZE, maxX - spanX + 1);
+                int covered = kernels.ShadeSpan(setup, y, spanX, count, bgra, coverage);
+
+                pixelsTested += count;
+                pixelsWritten += covered;
+
+                if (covered > 0)
+                    writeSpan(y, spanX, count, covered, bgra, coverage);
+            }
+        }
+
+        PROFILE_COUNT(Counter::TRIANGLES_RASTERIZED, 1);
+        PROFILE_COUNT(Counter::PIXELS_TESTED, pixelsTested);
+        PROFILE_COUNT(Counter::PIXELS_WRITTEN, pixelsWritten);
+    }
+}
+
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, vec3f c0, vec3f c1, vec3f c2, const ScissorRect& scissor)
+{
+    // Few-pixel triangles skip the full setup below
+    if (IsSmallTriangle(v0, v1, v2))
+    {
+        DrawSmallTriangle(image, v0, v1, v2, c0, c1, c2, scissor);
+        return;
+    }
+
+    // Covered pixels are copied to the image
+    ShadeSpans(v0, v1, v2, c0, c1, c2, scissor, [&](int y, int spanX, int count, int covered, const uint8_t* bgra, const uint8_t* coverage)
+    {
+        for (int i = 0; covered > 0 && i < count; ++i)
+        {
+            if (coverage[i])
+            {
+                image.set(spanX + i, y, TGAColor(&bgra[i * 4], 4));
+                --covered;
+            }
+        }
+    });
+}
+
+void DrawTriangleBC(TileBuffer& tile, const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const BlendState& blend)
+{
+    if (IsSmallTriangle(v0, v1, v2))
+    {
+        SmallTriangleBatch batch(tile);
+        batch.Add(v0, v1, v2, c0, c1, c2, blend);
+        return;
+    }
+
+    const ScissorRect rect = GetTileRect(tile);
+    const Kernels& kernels = GetKernels();
+
+    // Whole spans are blended into the tile rows, the coverage picks the pixels that change
+    ShadeSpans(v0, v1, v2, c0, c1, c2, rect, [&](int y, int spanX, int count, int, uint8_t* bgra, const uint8_t* coverage)
+    {
+        for (int i = 0; i < count; ++i)
+            bgra[i * 4 + 3] = blend.alpha;
+
+        kernels.BlendSpan(bgra, coverage, count, blend.mode, tile.GetPixel(spanX, y));
+    });
+}
+
+TriangleSetup SetupTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2)
+{
+    const float attributes0[FIXED_FUNCTION_VARYINGS] = { c0.x, c0.y, c0.z, 1, 1 };
+    const float attributes1[FIXED_FUNCTION_VARYINGS] = { c1.x, c1.y, c1.z, 0, 1 };
+    const float attributes2[FIXED_FUNCTION_VARYINGS] = { c2.x, c2.y, c2.z, 0, 0 };
+
+    return SetupTriangle(v0, v1, v2, attributes0, attributes1, attributes2, FIXED_FUNCTION_VARYINGS);
+}
+
+TriangleSetup SetupTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const float* attributes0, const float* attributes1, const float* attributes2, int count)
+{
+    TriangleSetup setup;
+    setup.v0 = v0;
+    setup.v1 = v1;
+    setup.v2 = v2;
+
+    setup.area = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY());
+
+    SetupVaryingPlanes(setup.varyings, v0, v1, v2, attributes0, attributes1, attributes2, count);
+
+    return setup;
+}
+
+void EdgeWeights(const TriangleSetup& setup, float x, float y, float& u, float& s, float& t)
+{
+    const vec4f& v0 = setup.v0;
+    const vec4f& v1 = setup.v1;
+    const vec4f& v2 = setup.v2;
+
+    // Same as vec2f::EdgeFunction without building the temporaries
+    u = (x - v1.x) * (v2.y - v1.y) - (y - v1.y) * (v2.x - v1.x);
+    s = (x - v2.x) * (v0.y - v2.y) - (y - v2.y) * (v0.x - v2.x);
+    t = (x - v0.x) * (v1.y - v0.y) - (y - v0.y) * (v1.x - v0.x);
+}
+
+TGAColor ShadeFragment(const TriangleSetup& setup, float x, float y)
+{
+    float varyings[MAX_VARYINGS];
+    InterpolateVaryings(setup.varyings, x, y, varyings);
+
+    TGAColor color;
+
+#ifdef VERTEX_COLOR
+    const float* linearColor = &varyings[VARYING_COLOR];
+    color = TGAColor(linearColor[0] * 255, linearColor[1] * 255, linearColor[2] * 255);
+#endif // VERTEX_COLOR
+
+#ifndef VERTEX_COLOR
+    const float* tc = &varyings[VARYING_TEXCOORD];
+
+    const int M = 10;
+    // checkerboard pattern
+    float p = (fmod(tc[0] * M, 1.0) > 0.5) ^ (fmod(tc[1] * M, 1.0) < 0.5);
+    color = TGAColor(p * 255, p * 255, p * 255);
+#endif // !VERTEX_COLOR
+
+    return color;
+}
+
+bool IsSmallTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2)
+{
+    // Same sample range as the loops in DrawTriangleBC
+    int minX = (int)min(v0.x, min(v1.x, v2.x));
+    int minY = (int)min(v0.y, min(v1.y, v2.y));
+    int maxX = (int)max(v0.x, max(v1.x, v2.x));
+    int maxY = (int)max(v0.y, max(v1.y, v2.y));
+
+    return (maxX - minX) < SMALL_TRIANGLE_SIZE && (maxY - minY) < SMALL_TRIANGLE_SIZE;
+}
+
+void DrawSmallTriangle(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const ScissorRect& scissor)
+{
+    SmallTriangleBatch batch(image, scissor);
+    batch.Add(v0, v1, v2, c0, c1, c2);
+}
+
+SmallTriangleBatch::SmallTriangleBatch(TGAImage& image)
+    : SmallTriangleBatch(image, GetImageRect(image))
+{
+}
+
+SmallTriangleBatch::SmallTriangleBatch(TGAImage& image, const ScissorRect& scissor)
+    : image(&image), tile(nullptr), scissor(scissor), count(0)
+{
+    ResetLanes();
+}
+
+SmallTriangleBatch::SmallTriangleBatch(TileBuffer& tile)
+    : image(nullptr), tile(&tile), scissor(GetTileRect(tile)), count(0)
+{
+    ResetLanes();
+}
+
+void SmallTriangleBatch::ResetLanes()
+{
+    for (int lane = 0; lane < SMALL_TRIANGLE_BATCH; ++lane)
+    {
+        x0[lane] = y0[lane] = x1[lane] = y1[lane] = x2[lane] = y2[lane] = 0;
+        originX[lane] = originY[lane] = 0;
+        maxX[lane] = maxY[lane] = -1;
+    }
+}
+
+SmallTriangleBatch::~SmallTriangleBatch()
+{
+    Flush();
+}
+
+void SmallTriangleBatch::Add(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const BlendState& blend)
+{
+    if (count == SMALL_TRIANGLE_BATCH)
+        Flush();
+
+    const int lane = count++;
+
+    x0[lane] = v0.x; y0[lane] = v0.y;
+    x1[lane] = v1.x; y1[lane] = v1.y;
+    x2[lane] = v2.x; y2[lane] = v2.y;
+
+    // Snap to the sample grid
+    originX[lane] = (float)(int)min(v0.x, min(v1.x, v2.x));
+    originY[lane] = (float)(int)min(v0.y, min(v1.y, v2.y));
+    maxX[lane] = max(v0.x, max(v1.x, v2.x));
+    maxY[lane] = max(v0.y, max(v1.y, v2.y));
+
+    vertices[lane][0] = v0;
+    vertices[lane][1] = v1;
+    vertices[lane][2] = v2;
+
+    colors[lane][0] = c0;
+    colors[lane][1] = c1;
+    colors[lane][2] = c2;
+
+    blends[lane] = blend;
+}
+
+void SmallTriangleBatch::Flush()
+{
+    if (count == 0)
+        return;
+
+    // Unused lanes get empty bounds so they never cover a sample
+    for (int lane = count; lane < SMALL_TRIANGLE_BATCH; ++lane)
+    {
+        originX[lane] = originY[lane] = 0;
+        maxX[lane] = maxY[lane] = -1;
+    }
+
+    const float scissorMinX = (float)scissor.minX;
+    const float scissorMinY = (float)scissor.minY;
+    const float scissorMaxX = (float)scissor.maxX;
+    const float scissorMaxY = (float)scissor.maxY;
+
+    // Bit (j * SMALL_TRIANGLE_SIZE + i) is set if sample (originX + i, originY + j) is covered
+    alignas(32) uint32_t coverage[SMALL_TRIANGLE_BATCH] = {};
+
+    for (int j = 0; j < SMALL_TRIANGLE_SIZE; ++j)
+    {
+        for (int i = 0; i < SMALL_TRIANGLE_SIZE; ++i)
+        {
+            const uint32_t bit = 1u << (j * SMALL_TRIANGLE_SIZE + i);
+
+            // Straight line code over the lanes so the compiler can keep the whole batch in vector registers
+            for (int lane = 0; lane < SMALL_TRIANGLE_BATCH; ++lane)
+            {
+                float px = originX[lane] + i;
+                float py = originY[lane] + j;
+
+                // Same edge functions as DrawTriangleBC
+                float u = (px - x1[lane]) * (y2[lane] - y1[lane]) - (py - y1[lane]) * (x2[lane] - x1[lane]);
+                float s = (px - x2[lane]) * (y0[lane] - y2[lane]) - (py - y2[lane]) * (x0[lane] - x2[lane]);
+                float t = (px - x0[lane]) * (y1[lane] - y0[lane]) - (py - y0[lane]) * (x1[lane] - x0[lane]);
+
+                bool inside = (u <= 0) & (s <= 0) & (t <= 0) & (px <= maxX[lane]) & (py <= maxY[lane]) &
+                    (px >= scissorMinX) & (px <= scissorMaxX) & (py >= scissorMinY) & (py <= scissorMaxY);
+                coverage[lane] |= inside ? bit : 0;
+            }
+        }
+    }
+
+    PROFILE_COUNT(Counter::TRIANGLES_RASTERIZED, count);
+    PROFILE_COUNT(Counter::PIXELS_TESTED, count * SMALL_TRIANGLE_SIZE * SMALL_TRIANGLE_SIZE);
+
+    for (int lane = 0; lane < count; ++lane)
+    {
+        // Reject triangles that do not cover any sample before paying for the attribute setup
+        if (coverage[lane] == 0)
+            continue;
+
+        uint64_t pixelsWritten = 0;
+
+        TriangleSetup setup = SetupTriangle(vertices[lane][0], vertices[lane][1], vertices[lane][2],
+            colors[lane][0], colors[lane][1], colors[lane][2]);
+
+        for (uint32_t mask = coverage[lane]; mask != 0; mask &= mask - 1)
+        {
+            int index = 0;
+            while (!(mask & (1u << index)))
+                ++index;
+
+            float px = originX[lane] + (index % SMALL_TRIANGLE_SIZE);
+            float py = originY[lane] + (index / SMALL_TRIANGLE_SIZE);
+
+            TGAColor color = ShadeFragment(setup, px, py);
+
+            if (tile)
+            {
+                color.bgra[3] = blends[lane].alpha;
+                tile->Blend((int)px, (int)py, color, blends[lane].mode);
+            }
+            else
+            {
+                image->set(px, py, color);
+            }
+            ++pixelsWritten;
+        }
+
+        PROFILE_COUNT(Counter::PIXELS_WRITTEN, pixelsWritten);
+    }
+
+    count = 0;
+}
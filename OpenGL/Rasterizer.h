@@ -0,0 +1,109 @@
+#pragma once
+#include "Vector.h"
+#include "tgaimage.h"
+#include "Varyings.h"
+#include "Blend.h"
+
+#define PERSPECTIVE_DIVIDE
+#define VERTEX_COLOR
+
+// Triangles whose sample bounds fit in SMALL_TRIANGLE_SIZE x SMALL_TRIANGLE_SIZE take the small triangle path
+const int SMALL_TRIANGLE_SIZE = 4;
+
+// Number of small triangles evaluated together
+const int SMALL_TRIANGLE_BATCH = 8;
+
+// Inclusive pixel rectangle, samples outside of it are not drawn
+struct ScissorRect
+{
+	int minX, minY;
+	int maxX, maxY;
+};
+
+ScissorRect GetImageRect(const TGAImage& image);
+ScissorRect GetTileRect(const TileBuffer& tile);
+
+// Varyings of the fixed function shading: vertex color, then the texture coordinates of the checkerboard
+const int VARYING_COLOR = 0;
+const int VARYING_TEXCOORD = 3;
+const int FIXED_FUNCTION_VARYINGS = 5;
+
+// Per triangle values shared by the rasterization paths
+struct TriangleSetup
+{
+	vec4f v0, v1, v2;
+	float area;
+	VaryingPlanes varyings;
+};
+
+// Setup of the fixed function varyings, the vertex colors and texture coordinates of the checkerboard
+TriangleSetup SetupTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2);
+
+// Setup of count attributes per vertex, up to MAX_VARYINGS
+TriangleSetup SetupTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const float* attributes0, const float* attributes1, const float* attributes2, int count);
+
+// Edge function weights of sample (x, y), all of them <= 0 when the sample is inside the triangle
+void EdgeWeights(const TriangleSetup& setup, float x, float y, float& u, float& s, float& t);
+
+// Fixed function color of the sample at (x, y)
+TGAColor ShadeFragment(const TriangleSetup& setup, float x, float y);
+
+void ClearTarget(TGAImage& image, const uint32_t& width, const uint32_t& height, const TGAColor& color);
+
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2);
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, vec3f c0, vec3f c1, vec3f c2);
+void DrawTriangleBC(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, vec3f c0, vec3f c1, vec3f c2, const ScissorRect& scissor);
+
+// Blends the triangle into the pixels of the tile, the fragments get the alpha of the blend state
+void DrawTriangleBC(TileBuffer& tile, const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const BlendState& blend);
+
+bool IsSmallTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2);
+void DrawSmallTriangle(TGAImage& image, const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const ScissorRect& scissor);
+
+/*
+	Collects small triangles and rasterizes them together.
+	Each triangle is snapped to a 4x4 block of samples and the edge functions of
+	the whole batch are evaluated lane by lane, so the per triangle setup is only
+	paid for triangles that actually cover a sample.
+
+	Triangles are drawn in the order they were added, call Flush before drawing
+	anything else into the target to keep the submission order.
+	Drawing into an image only replaces pixels, a tile buffer target also blends.
+*/
+class SmallTriangleBatch
+{
+public:
+	SmallTriangleBatch(TGAImage& image);
+	SmallTriangleBatch(TGAImage& image, const ScissorRect& scissor);
+	SmallTriangleBatch(TileBuffer& tile);
+	~SmallTriangleBatch();
+
+	void Add(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, const BlendState& blend = BlendState());
+	void Flush();
+
+	int Size() const
+	{
+		return count;
+	}
+
+private:
+	void ResetLanes();
+
+	TGAImage* image;
+	TileBuffer* tile;
+	ScissorRect scissor;
+	int count;
+
+	// Screen positions, one lane per triangle
+	alignas(32) float x0[SMALL_TRIANGLE_BATCH], y0[SMALL_TRIANGLE_BATCH];
+	alignas(32) float x1[SMALL_TRIANGLE_BATCH], y1[SMALL_TRIANGLE_BATCH];
+	alignas(32) float x2[SMALL_TRIANGLE_BATCH], y2[SMALL_TRIANGLE_BATCH];
+	alignas(32) float maxX[SMALL_TRIANGLE_BATCH], maxY[SMALL_TRIANGLE_BATCH];
+
+	// Snapped sample origin of the 4x4 block
+	alignas(32) float originX[SMALL_TRIANGLE_BATCH], originY[SMALL_TRIANGLE_BATCH];
+
+	vec4f vertices[SMALL_TRIANGLE_BATCH][3];
+	vec3f colors[SMALL_TRIANGLE_BATCH][3];
+	BlendState blends[SMALL_TRIANGLE_BATCH];
+};
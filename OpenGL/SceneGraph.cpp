@@ -0,0 +1,215 @@
+#include "SceneGraph.h"
+#include <utility>
+
+// Most nodes a subtree handed to one job has, larger ones are split at their root
+const uint32_t SUBTREE_GRAIN = 256;
+
+uint32_t SceneGraph::AddNode(const trsf& local, uint32_t parent)
+{
+    const uint32_t id = (uint32_t)ids.size();
+    const uint32_t slot = (uint32_t)locals.size();
+    const uint32_t parentSlot = parent == NO_PARENT ? NO_PARENT : slots[parent];
+
+    locals.push_back(local);
+    worlds.push_back(affine4f::IDENTITY);
+    parents.push_back(parentSlot);
+    subtreeEnds.push_back(slot + 1);
+    flags.push_back(DIRTY);
+    updated.push_back(UINT32_MAX);
+    ids.push_back(id);
+    slots.push_back(slot);
+
+    if (parentSlot == NO_PARENT)
+        return id;
+
+    // Still in depth first order when the subtree of the parent ends at the new slot, the ancestors whose subtree
+    // ends there grow by one
+    if (sorted && subtreeEnds[parentSlot] == slot)
+    {
+        for (uint32_t ancestor = parentSlot; ancestor != NO_PARENT && subtreeEnds[ancestor] == slot; ancestor = parents[ancestor])
+            subtreeEnds[ancestor] = slot + 1;
+    }
+    else
+    {
+        sorted = false;
+    }
+
+    for (uint32_t ancestor = parentSlot; ancestor != NO_PARENT && !(flags[ancestor] & DIRTY_BELOW); ancestor = parents[ancestor])
+        flags[ancestor] |= DIRTY_BELOW;
+
+    return id;
+}
+
+uint32_t SceneGraph::GetParent(uint32_t node) const
+{
+    const uint32_t parentSlot = parents[slots[node]];
+
+    return parentSlot == NO_PARENT ? NO_PARENT : ids[parentSlot];
+}
+
+void SceneGraph::SetLocal(uint32_t node, const trsf& local)
+{
+    const uint32_t slot = slots[node];
+
+    locals[slot] = local;
+    flags[slot] |= DIRTY;
+
+    // An ancestor already marked has the rest of the path marked too
+    for (uint32_t ancestor = parents[slot]; ancestor != NO_PARENT && !(flags[ancestor] & DIRTY_BELOW); ancestor = parents[ancestor])
+        flags[ancestor] |= DIRTY_BELOW;
+}
+
+void SceneGraph::Sort()
+{
+    const uint32_t count = (uint32_t)locals.size();
+
+    // Parents always come before their children, so the sizes add up in one backward pass
+    std::vector<uint32_t> sizes(count, 1);
+    for (uint32_t slot = count; slot-- > 0;)
+    {
+        if (parents[slot] != NO_PARENT)
+            sizes[parents[slot]] += sizes[slot];
+    }
+
+    // Each node takes the next free position inside the range of its parent, in slot order so siblings keep theirs
+    std::vector<uint32_t> positions(count);
+    std::vector<uint32_t> nextChild(count);
+    uint32_t nextRoot = 0;
+
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        uint32_t& next = parents[slot] == NO_PARENT ? nextRoot : nextChild[parents[slot]];
+
+        positions[slot] = next;
+        next += sizes[slot];
+        nextChild[slot] = positions[slot] + 1;
+    }
+
+    std::vector<trsf> sortedLocals(count);
+    std::vector<affine4f> sortedWorlds(count);
+    std::vector<uint32_t> sortedParents(count);
+    std::vector<uint8_t> sortedFlags(count);
+    std::vector<uint32_t> sortedUpdated(count);
+    std::vector<uint32_t> sortedIds(count);
+
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        const uint32_t position = positions[slot];
+
+        sortedLocals[position] = locals[slot];
+        sortedWorlds[position] = worlds[slot];
+        sortedParents[position] = parents[slot] == NO_PARENT ? NO_PARENT : positions[parents[slot]];
+        sortedFlags[position] = flags[slot];
+        sortedUpdated[position] = updated[slot];
+        sortedIds[position] = ids[slot];
+
+        subtreeEnds[position] = position + sizes[slot];
+        slots[ids[slot]] = position;
+    }
+
+    locals = std::move(sortedLocals);
+    worlds = std::move(sortedWorlds);
+    parents = std::move(sortedParents);
+    flags = std::move(sortedFlags);
+    updated = std::move(sortedUpdated);
+    ids = std::move(sortedIds);
+
+    sorted = true;
+}
+
+bool SceneGraph::IsClean(uint32_t slot) const
+{
+    const uint32_t parent = parents[slot];
+
+    return !(flags[slot] & (DIRTY | DIRTY_BELOW)) && (parent == NO_PARENT || updated[parent] != updateIndex);
+}
+
+void SceneGraph::UpdateNode(uint32_t slot)
+{
+    const uint32_t parent = parents[slot];
+
+    // Nodes only on the path to a dirty one keep their matrix
+    if ((flags[slot] & DIRTY) || (parent != NO_PARENT && updated[parent] == updateIndex))
+    {
+        // Row vectors, the local transform applies first
+        worlds[slot] = parent == NO_PARENT ? locals[slot].ToAffine() : locals[slot].ToAffine() * worlds[parent];
+        updated[slot] = updateIndex;
+    }
+
+    flags[slot] = 0;
+}
+
+void SceneGraph::UpdateRange(uint32_t begin, uint32_t end)
+{
+    for (uint32_t slot = begin; slot < end;)
+    {
+        if (IsClean(slot))
+        {
+            slot = subtreeEnds[slot];
+            continue;
+        }
+
+        // The children are visited next
+        UpdateNode(slot);
+        ++slot;
+    }
+}
+
+void SceneGraph::Update()
+{
+    if (!sorted)
+        Sort();
+
+    ++updateIndex;
+    UpdateRange(0, (uint32_t)locals.size());
+}
+
+void SceneGraph::Update(JobSystem& jobs)
+{
+    if (!sorted)
+        Sort();
+
+    ++updateIndex;
+
+    // Roots of the large subtrees are updated here, the small subtrees under them are gathered in ranges of
+    // whole subtrees whose parents are done, which the jobs update without sharing a node
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    bool extendRange = false;
+
+    const uint32_t count = (uint32_t)locals.size();
+    for (uint32_t slot = 0; slot < count;)
+    {
+        const uint32_t end = subtreeEnds[slot];
+
+        if (IsClean(slot))
+        {
+            slot = end;
+            continue;
+        }
+
+        if (end - slot <= SUBTREE_GRAIN)
+        {
+            // Clean subtrees skipped in between are skipped again by UpdateRange
+            if (extendRange && end - ranges.back().first <= SUBTREE_GRAIN)
+                ranges.back().second = end;
+            else
+                ranges.push_back({ slot, end });
+
+            extendRange = true;
+            slot = end;
+            continue;
+        }
+
+        UpdateNode(slot);
+
+        // A range can't reach over a node updated here
+        extendRange = false;
+        ++slot;
+    }
+
+    jobs.ParallelFor(0, ranges.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t range = begin; range < end; ++range)
+            UpdateRange(ranges[range].first, ranges[range].second);
+    });
+}
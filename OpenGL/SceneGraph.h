@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Matrix.h"
+#include "JobSystem.h"
+
+/*
+	Transform hierarchy: every node has a local TRS relative to its parent and a cached world matrix, local then
+	the parents up to the root.
+
+	The nodes are kept in depth first order in flat arrays, a parent before its children and every subtree a
+	contiguous range of slots, so an update is one forward pass and subtrees can be updated on different
+	threads. Ids stay the same when the slots move.
+
+	SetLocal only marks the node dirty and its ancestors as having something dirty below, Update then
+	recomputes the dirty nodes and everything under them and jumps over the subtrees where nothing changed.
+	An animated scene where a few nodes move per frame pays for those nodes, not for the whole hierarchy.
+*/
+class SceneGraph
+{
+public:
+	// Parent of the root nodes
+	static const uint32_t NO_PARENT = UINT32_MAX;
+
+	// Node under parent, which has to exist already. Returns the id of the node, the ids count up from 0
+	uint32_t AddNode(const trsf& local, uint32_t parent = NO_PARENT);
+
+	size_t GetNodeCount() const
+	{
+		return ids.size();
+	}
+
+	uint32_t GetParent(uint32_t node) const;
+
+	const trsf& GetLocal(uint32_t node) const
+	{
+		return locals[slots[node]];
+	}
+
+	// The world matrices of node and of the nodes below it are recomputed by the next Update
+	void SetLocal(uint32_t node, const trsf& local);
+
+	// World matrix as of the last Update
+	const affine4f& GetWorld(uint32_t node) const
+	{
+		return worlds[slots[node]];
+	}
+
+	// True when the last Update recomputed the world matrix of node
+	bool IsWorldChanged(uint32_t node) const
+	{
+		return updated[slots[node]] == updateIndex;
+	}
+
+	// Recomputes the world matrices of the dirty nodes and of every node below them
+	void Update();
+
+	// Same results as Update, the subtrees are split over the job system
+	void Update(JobSystem& jobs);
+
+private:
+	enum Flags : uint8_t
+	{
+		DIRTY = 1,			// The local TRS changed
+		DIRTY_BELOW = 2		// A node of the subtree is dirty
+	};
+
+	// Depth first order after nodes were added out of it, siblings keep the order they were added in
+	void Sort();
+
+	// Nothing to recompute in the subtree of slot
+	bool IsClean(uint32_t slot) const;
+
+	// Recomputes the world matrix of a node of a subtree that isn't clean when it or its parent changed
+	void UpdateNode(uint32_t slot);
+
+	// Updates the nodes of begin to end, whole subtrees whose parents are up to date
+	void UpdateRange(uint32_t begin, uint32_t end);
+
+	// Per slot
+	std::vector<trsf> locals;
+	std::vector<affine4f> worlds;
+	std::vector<uint32_t> parents;		// Slot of the parent, NO_PARENT for a root
+	std::vector<uint32_t> subtreeEnds;	// One past the last slot of the subtree
+	std::vector<uint8_t> flags;
+	std::vector<uint32_t> updated;		// Last Update that recomputed the world matrix
+	std::vector<uint32_t> ids;
+
+	// Slot of every id
+	std::vector<uint32_t> slots;
+
+	uint32_t updateIndex = 0;
+
+	// False when subtreeEnds is out of date until the next Sort
+	bool sorted = true;
+};
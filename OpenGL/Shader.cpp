@@ -0,0 +1,114 @@
+#include "Shader.h"
+#include "MathCommon.h"
+
+namespace
+{
+    // Vertex of the edge from previous to current crossing the plane, interpolated like ClipAgainstPlane does
+    void Intersect(Plane plane, const ShadedVertex& previous, const ShadedVertex& current, int varyingCount, ShadedVertex& out)
+    {
+        float ratio = GetIntersectionRatio(plane, current.position, previous.position);
+
+        out.position = Lerp(previous.position, current.position, ratio);
+
+        for (int k = 0; k < varyingCount; ++k)
+            out.varyings[k] = Lerp(previous.varyings[k], current.varyings[k], ratio);
+    }
+
+    // Adapters running a ShaderProgram through the templated loops
+    struct ProgramVertexShader
+    {
+        static const int VARYING_COUNT = MAX_VARYINGS;
+
+        const ShaderProgram& program;
+        int varyingCount;
+
+        vec4f operator()(uint32_t vertex, float* varyings) const
+        {
+            // Varyings the program doesn't write become zero planes
+            for (int k = varyingCount; k < MAX_VARYINGS; ++k)
+                varyings[k] = 0;
+
+            return program.ShadeVertex(vertex, varyings);
+        }
+    };
+
+    struct ProgramFragmentShader
+    {
+        static const int VARYING_COUNT = MAX_VARYINGS;
+
+        const ShaderProgram& program;
+
+        TGAColor operator()(const float* varyings) const
+        {
+            return program.ShadeFragment(varyings);
+        }
+    };
+}
+
+int ClipShadedTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, int varyingCount, ShadedVertex* out)
+{
+    out[0] = v0;
+    out[1] = v1;
+    out[2] = v2;
+
+    if (IsInsideFrustum(v0.position) && IsInsideFrustum(v1.position) && IsInsideFrustum(v2.position))
+        return 3;
+
+    PROFILE_COUNT(Counter::TRIANGLES_CLIPPED, 1);
+
+    // Same plane order as ClipTriangle, the polygon is clipped in place through a second buffer
+    const Plane planes[] = { Plane::POSITIVEW, Plane::RIGHT, Plane::LEFT, Plane::TOP, Plane::BOTTOM, Plane::NEAR, Plane::FAR };
+
+    ShadedVertex scratch[MAX_CLIPPED_VERTICES];
+    ShadedVertex* input = out;
+    ShadedVertex* output = scratch;
+    int count = 3;
+
+    for (Plane plane : planes)
+    {
+        int outputCount = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const ShadedVertex& previous = input[(i + count - 1) % count];
+            const ShadedVertex& current = input[i];
+
+            bool isPreviousInside = IsInsidePlane(plane, previous.position);
+            bool isCurrentInside = IsInsidePlane(plane, current.position);
+
+            if (isPreviousInside != isCurrentInside)
+                Intersect(plane, previous, current, varyingCount, output[outputCount++]);
+
+            if (isCurrentInside)
+                output[outputCount++] = current;
+        }
+
+        std::swap(input, output);
+        count = outputCount;
+
+        if (count < 3)
+            return 0;
+    }
+
+    // An even number of swaps leaves the polygon in out already
+    if (input != out)
+    {
+        for (int i = 0; i < count; ++i)
+            out[i] = input[i];
+    }
+
+    return count;
+}
+
+void DrawIndexed(TGAImage& image, const uint32_t* indices, size_t indexCount, size_t vertexCount, const ShaderProgram& program, const ScissorRect& scissor)
+{
+    ProgramVertexShader vertexShader = { program, std::min(program.GetVaryingCount(), MAX_VARYINGS) };
+    ProgramFragmentShader fragmentShader = { program };
+
+    DrawIndexed(image, indices, indexCount, vertexCount, vertexShader, fragmentShader, scissor, program.GetBlendMode());
+}
+
+void DrawIndexed(TGAImage& image, const Mesh& mesh, const ShaderProgram& program)
+{
+    DrawIndexed(image, mesh.indices.data(), mesh.indices.size(), mesh.positions.size(), program, GetImageRect(image));
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Triangle.h"
+#include "Rasterizer.h"
+#include "Pipeline.h"
+#include "Profiler.h"
+#include "Kernels.h"
+
+/*
+	Programmable shading.
+
+	A vertex shader is a functor with a VARYING_COUNT constant and
+		vec4f operator()(uint32_t vertex, float* varyings) const
+	returning the clip space position of the vertex and writing its VARYING_COUNT varyings.
+
+	A fragment shader is a functor with a VARYING_COUNT constant, at most the one of the vertex shader, and
+		TGAColor operator()(const float* varyings) const
+	getting the perspective correct varyings of the pixel.
+
+	DrawIndexed is instantiated for every pair of shaders, so both are inlined into the loops below and the
+	varying count is known at compile time. ShaderProgram is the virtual interface for shaders only known at
+	run time, it goes through the same loops with one indirect call per vertex and per pixel.
+*/
+
+// Clip space vertex with the varyings written by the vertex shader
+struct ShadedVertex
+{
+	vec4f position;
+	float varyings[MAX_VARYINGS];
+};
+
+// Most vertices of a triangle clipped by the 7 planes, each plane adds at most one
+const int MAX_CLIPPED_VERTICES = 10;
+
+// Clips the triangle against the view frustum, writes the vertices of the convex polygon left to out and returns
+// how many there are, 0 when nothing is left. Only the first varyingCount varyings are interpolated
+int ClipShadedTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, int varyingCount, ShadedVertex* out);
+
+// Shader pair given at run time
+class ShaderProgram
+{
+public:
+	virtual ~ShaderProgram()
+	{}
+
+	// At most MAX_VARYINGS
+	virtual int GetVaryingCount() const = 0;
+
+	virtual vec4f ShadeVertex(uint32_t vertex, float* varyings) const = 0;
+	virtual TGAColor ShadeFragment(const float* varyings) const = 0;
+
+	// How the alpha of the fragments is used
+	virtual BlendMode GetBlendMode() const
+	{
+		return BlendMode::REPLACE;
+	}
+};
+
+// Draws the raster space triangle, the color of fragmentShader is blended into every covered pixel inside the scissor rectangle
+template<class FragmentShader>
+void DrawShadedTriangle(TGAImage& image, const TriangleSetup& setup, const FragmentShader& fragmentShader, const ScissorRect& scissor,
+	BlendMode blend = BlendMode::REPLACE)
+{
+	const int VARYING_COUNT = FragmentShader::VARYING_COUNT;
+
+	const float x0 = setup.v0.x, y0 = setup.v0.y;
+	const float x1 = setup.v1.x, y1 = setup.v1.y;
+	const float x2 = setup.v2.x, y2 = setup.v2.y;
+
+	const int minX = (int)std::max(std::min(x0, std::min(x1, x2)), (float)scissor.minX);
+	const int minY = (int)std::max(std::min(y0, std::min(y1, y2)), (float)scissor.minY);
+	const int maxX = (int)std::floor(std::min(std::max(x0, std::max(x1, x2)), (float)scissor.maxX));
+	const int maxY = (int)std::floor(std::min(std::max(y0, std::max(y1, y2)), (float)scissor.maxY));
+
+	const VaryingPlanes& planes = setup.varyings;
+
+	// Coverage and varyings of a span, one array per varying so the first loop vectorizes across pixels
+	alignas(64) uint8_t coverage[SPAN_SIZE];
+	alignas(64) float values[VARYING_COUNT > 0 ? VARYING_COUNT : 1][SPAN_SIZE];
+
+	uint64_t pixelsTested = 0;
+	uint64_t pixelsWritten = 0;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float py = (float)y;
+		const float dy = py - planes.originY;
+		const float rowW = planes.bW * dy + planes.cW;
+
+		float row[VARYING_COUNT > 0 ? VARYING_COUNT : 1];
+		for (int k = 0; k < VARYING_COUNT; ++k)
+			row[k] = planes.b[k] * dy + planes.c[k];
+
+		for (int spanX = minX; spanX <= maxX; spanX += SPAN_SIZE)
+		{
+			const int count = std::min(SPAN_SIZE, maxX - spanX + 1);
+
+			int covered = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				const float px = (float)(spanX + i);
+
+				// Same edge functions as EdgeWeights
+				float u = (px - x1) * (y2 - y1) - (py - y1) * (x2 - x1);
+				float s = (px - x2) * (y0 - y2) - (py - y2) * (x0 - x2);
+				float t = (px - x0) * (y1 - y0) - (py - y0) * (x1 - x0);
+
+				uint8_t inside = (u <= 0) & (s <= 0) & (t <= 0);
+				coverage[i] = inside;
+				covered += inside;
+
+				const float dx = px - planes.originX;
+				const float w = 1 / (planes.aW * dx + rowW);
+
+				for (int k = 0; k < VARYING_COUNT; ++k)
+					values[k][i] = (planes.a[k] * dx + row[k]) * w;
+			}
+
+			pixelsTested += count;
+			pixelsWritten += covered;
+
+			for (int i = 0; covered > 0 && i < count; ++i)
+			{
+				if (!coverage[i])
+					continue;
+
+				float varyings[VARYING_COUNT > 0 ? VARYING_COUNT : 1];
+				for (int k = 0; k < VARYING_COUNT; ++k)
+					varyings[k] = values[k][i];
+
+				TGAColor color = fragmentShader(varyings);
+
+				if (blend != BlendMode::REPLACE)
+				{
+					TGAColor destination = image.get(spanX + i, y);
+					BlendPixel(color.bgra, destination.bgra, blend);
+					color = destination;
+				}
+
+				image.set(spanX + i, y, color);
+				--covered;
+			}
+		}
+	}
+
+	PROFILE_COUNT(Counter::TRIANGLES_RASTERIZED, 1);
+	PROFILE_COUNT(Counter::PIXELS_TESTED, pixelsTested);
+	PROFILE_COUNT(Counter::PIXELS_WRITTEN, pixelsWritten);
+}
+
+// Shades vertexCount vertices, then clips and draws the indexed triangles in order
+template<class VertexShader, class FragmentShader>
+void DrawIndexed(TGAImage& image, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+	const VertexShader& vertexShader, const FragmentShader& fragmentShader, const ScissorRect& scissor, BlendMode blend = BlendMode::REPLACE)
+{
+	const int VARYING_COUNT = VertexShader::VARYING_COUNT;
+
+	static_assert(VertexShader::VARYING_COUNT <= MAX_VARYINGS, "Too many varyings");
+	static_assert(FragmentShader::VARYING_COUNT <= VertexShader::VARYING_COUNT, "The fragment shader reads varyings the vertex shader doesn't write");
+
+	PROFILE_COUNT(Counter::TRIANGLES_SUBMITTED, indexCount / 3);
+
+	const float width = (float)image.get_width();
+	const float height = (float)image.get_height();
+
+	std::vector<ShadedVertex> vertices(vertexCount);
+	{
+		PROFILE_SCOPE("vertex shader");
+
+		for (size_t i = 0; i < vertexCount; ++i)
+			vertices[i].position = vertexShader((uint32_t)i, vertices[i].varyings);
+	}
+
+	PROFILE_SCOPE("clip and raster");
+
+	ShadedVertex polygon[MAX_CLIPPED_VERTICES];
+	vec4f rasterVertices[MAX_CLIPPED_VERTICES];
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		int polygonCount = ClipShadedTriangle(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], VARYING_COUNT, polygon);
+
+		for (int j = 0; j < polygonCount; ++j)
+			rasterVertices[j] = ConvertToRaster(polygon[j].position, width, height);
+
+		// Same fan as the triangle clipper
+		for (int j = 1; j + 1 < polygonCount; ++j)
+		{
+			const vec4f& v0 = rasterVertices[0];
+			const vec4f& v1 = rasterVertices[j];
+			const vec4f& v2 = rasterVertices[j + 1];
+
+			if (IsTriangleCulled(Triangle(v0, v1, v2), width, height))
+				continue;
+
+			TriangleSetup setup = SetupTriangle(v0, v1, v2, polygon[0].varyings, polygon[j].varyings, polygon[j + 1].varyings, VARYING_COUNT);
+			DrawShadedTriangle(image, setup, fragmentShader, scissor, blend);
+		}
+	}
+}
+
+template<class VertexShader, class FragmentShader>
+void DrawIndexed(TGAImage& image, const Mesh& mesh, const VertexShader& vertexShader, const FragmentShader& fragmentShader,
+	BlendMode blend = BlendMode::REPLACE)
+{
+	DrawIndexed(image, mesh.indices.data(), mesh.indices.size(), mesh.positions.size(), vertexShader, fragmentShader, GetImageRect(image), blend);
+}
+
+// Type erased version, every program interpolates MAX_VARYINGS varyings
+void DrawIndexed(TGAImage& image, const uint32_t* indices, size_t indexCount, size_t vertexCount, const ShaderProgram& program, const ScissorRect& scissor);
+void DrawIndexed(TGAImage& image, const Mesh& mesh, const ShaderProgram& program);
+
+// Vertex shader of the fixed function pipeline, mesh positions transformed by modelViewProjection and the vertex colors as varyings
+struct MeshVertexShader
+{
+	static const int VARYING_COUNT = 3;
+
+	const Mesh& mesh;
+	mat4f modelViewProjection;
+
+	MeshVertexShader(const Mesh& mesh, const mat4f& modelViewProjection)
+		: mesh(mesh), modelViewProjection(modelViewProjection)
+	{}
+
+	vec4f operator()(uint32_t vertex, float* varyings) const
+	{
+		vec3f color = mesh.colors.empty() ? vec3f(1, 1, 1) : mesh.colors[vertex];
+		varyings[0] = color.x;
+		varyings[1] = color.y;
+		varyings[2] = color.z;
+
+		return modelViewProjection * vec4f(mesh.positions[vertex]);
+	}
+};
+
+// Interpolated vertex color
+struct VertexColorShader
+{
+	static const int VARYING_COUNT = 3;
+
+	TGAColor operator()(const float* varyings) const
+	{
+		return TGAColor(varyings[0] * 255, varyings[1] * 255, varyings[2] * 255);
+	}
+};
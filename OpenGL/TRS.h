@@ -0,0 +1,70 @@
+#pragma once
+#include <type_traits>
+#include "Vector.h"
+#include "Matrix3.h"
+#include "AffineMatrix4.h"
+
+/*
+	Scale, then rotation, then translation, kept apart instead of multiplied into a matrix.
+
+	Building the matrix is 9 multiplies, and since the rotation is orthonormal the inverse is its transpose
+	divided by the scale, no determinant or cofactor is needed.
+*/
+template <class Type>
+class TRS
+{
+public:
+	vec3<Type> translation;
+	Matrix3<Type> rotation;		// Orthonormal, row vector layout like Matrix3::Rotation
+	vec3<Type> scale;
+
+public:
+	constexpr TRS()
+		: translation(0, 0, 0), rotation(Matrix3<Type>::IDENTITY), scale(1, 1, 1)
+	{}
+
+	constexpr TRS(const vec3<Type>& translation, const Matrix3<Type>& rotation, const vec3<Type>& scale)
+		: translation(translation), rotation(rotation), scale(scale)
+	{}
+
+	// v * S * R + t, row i of S * R is row i of R times the scale of axis i
+	constexpr AffineMatrix4<Type> ToAffine() const
+	{
+		return AffineMatrix4<Type>(rotation[0] * scale.x, rotation[1] * scale.x, rotation[2] * scale.x,
+			rotation[3] * scale.y, rotation[4] * scale.y, rotation[5] * scale.y,
+			rotation[6] * scale.z, rotation[7] * scale.z, rotation[8] * scale.z,
+			translation.x, translation.y, translation.z);
+	}
+
+	constexpr Matrix4<Type> ToMatrix4() const
+	{
+		return ToAffine().ToMatrix4();
+	}
+
+	// (v - t) * transpose(R) / S, a zero scale gives infinities
+	constexpr AffineMatrix4<Type> InverseAffine() const
+	{
+		const Type invX = 1 / scale.x;
+		const Type invY = 1 / scale.y;
+		const Type invZ = 1 / scale.z;
+
+		Matrix3<Type> inverseLinear(rotation[0] * invX, rotation[3] * invY, rotation[6] * invZ,
+			rotation[1] * invX, rotation[4] * invY, rotation[7] * invZ,
+			rotation[2] * invX, rotation[5] * invY, rotation[8] * invZ);
+
+		vec3<Type> offset = inverseLinear * translation;
+
+		return AffineMatrix4<Type>(inverseLinear, vec3<Type>(-offset.x, -offset.y, -offset.z));
+	}
+
+	constexpr vec3<Type> TransformPoint(const vec3<Type>& point) const
+	{
+		vec3<Type> scaled(point.x * scale.x, point.y * scale.y, point.z * scale.z);
+
+		return vec3<Type>(scaled.x * rotation[0] + scaled.y * rotation[3] + scaled.z * rotation[6] + translation.x,
+			scaled.x * rotation[1] + scaled.y * rotation[4] + scaled.z * rotation[7] + translation.y,
+			scaled.x * rotation[2] + scaled.y * rotation[5] + scaled.z * rotation[8] + translation.z);
+	}
+};
+
+static_assert(std::is_trivially_copyable<TRS<float>>::value, "TRS is copied as plain memory");
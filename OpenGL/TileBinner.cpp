@@ -0,0 +1,220 @@
+#include "TileBinner.h"
+#include "Rasterizer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+TileBinner::TileBinner(int width, int height, int tileSize)
+    : width(width), height(height), tileSize(tileSize)
+{
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+}
+
+void TileBinner::Reset(int threadCount)
+{
+    if ((int)threads.size() < threadCount)
+        threads.resize(threadCount);
+
+    for (ThreadBins& bins : threads)
+    {
+        bins.triangles.Clear();
+        bins.blends.clear();
+        bins.tiles.resize(GetTileCount());
+
+        for (vector<BinEntry>& tile : bins.tiles)
+            tile.clear();
+    }
+}
+
+size_t TileBinner::GetTriangleCount() const
+{
+    size_t count = 0;
+    for (const ThreadBins& bins : threads)
+        count += bins.triangles.Size();
+
+    return count;
+}
+
+void TileBinner::Bin(int thread, const TriangleBatch& triangles, size_t firstTriangle, const BlendState& blend)
+{
+    const size_t LANES = TriangleBatch::LANES;
+    const size_t count = triangles.Size();
+
+    const float* x0 = triangles.Get(TriangleBatch::X, 0);
+    const float* y0 = triangles.Get(TriangleBatch::Y, 0);
+    const float* x1 = triangles.Get(TriangleBatch::X, 1);
+    const float* y1 = triangles.Get(TriangleBatch::Y, 1);
+    const float* x2 = triangles.Get(TriangleBatch::X, 2);
+    const float* y2 = triangles.Get(TriangleBatch::Y, 2);
+    const uint32_t* ids = triangles.GetIds();
+
+    ThreadBins& bins = threads[thread];
+
+    // Geometry already culled the triangles covering no sample, so the whole batch is kept and the bins index into it
+    const uint32_t first = (uint32_t)bins.triangles.Size();
+    bins.triangles.Append(triangles);
+    bins.blends.resize(bins.blends.size() + count, blend);
+
+    // Pieces seen so far of the current input triangle
+    int subTriangle = 0;
+
+    for (size_t base = 0; base < count; base += LANES)
+    {
+        // Tiles of the first and last sample the rasterizer can visit, a group of lanes at a time
+        int minX[LANES], minY[LANES], maxX[LANES], maxY[LANES];
+
+        // The last group stops at count, the padding of the arrays is never initialized
+        const size_t laneCount = min(LANES, count - base);
+
+        for (size_t lane = 0; lane < laneCount; ++lane)
+        {
+            const size_t i = base + lane;
+
+            minX[lane] = max(0, (int)min(x0[i], min(x1[i], x2[i])));
+            minY[lane] = max(0, (int)min(y0[i], min(y1[i], y2[i])));
+            maxX[lane] = min(width - 1, (int)floor(max(x0[i], max(x1[i], x2[i]))));
+            maxY[lane] = min(height - 1, (int)floor(max(y0[i], max(y1[i], y2[i]))));
+        }
+
+        for (size_t lane = 0; lane < laneCount; ++lane)
+        {
+            const size_t i = base + lane;
+
+            subTriangle = (i > 0 && ids[i] == ids[i - 1]) ? subTriangle + 1 : 0;
+
+            if (minX[lane] > maxX[lane] || minY[lane] > maxY[lane])
+                continue;
+
+            const uint64_t sequence = MakeSequence(firstTriangle + ids[i], subTriangle);
+            const uint32_t index = first + (uint32_t)i;
+
+            for (int tileY = minY[lane] / tileSize; tileY <= maxY[lane] / tileSize; ++tileY)
+            {
+                for (int tileX = minX[lane] / tileSize; tileX <= maxX[lane] / tileSize; ++tileX)
+                    bins.tiles[tileX + tileY * tilesX].push_back({ sequence, index });
+            }
+        }
+    }
+}
+
+void TileBinner::GatherTile(int tile, vector<TileTriangle>& triangles) const
+{
+    struct Run
+    {
+        const ThreadBins* bins;
+        const BinEntry* current;
+        const BinEntry* end;
+    };
+
+    // Split every bin in its increasing runs
+    vector<Run> runs;
+
+    for (const ThreadBins& bins : threads)
+    {
+        const vector<BinEntry>& bin = bins.tiles[tile];
+        if (bin.empty())
+            continue;
+
+        const BinEntry* start = bin.data();
+        const BinEntry* end = bin.data() + bin.size();
+
+        for (const BinEntry* entry = start + 1; entry < end; ++entry)
+        {
+            if (entry->sequence < (entry - 1)->sequence)
+            {
+                runs.push_back({ &bins, start, entry });
+                start = entry;
+            }
+        }
+
+        runs.push_back({ &bins, start, end });
+    }
+
+    // Merge on a min-heap of the run heads. A run keeps going without touching the heap while its head is
+    // still the smallest, long runs cost one heap operation per switch to another run
+    auto later = [](const Run& a, const Run& b) { return a.current->sequence > b.current->sequence; };
+    make_heap(runs.begin(), runs.end(), later);
+
+    while (!runs.empty())
+    {
+        pop_heap(runs.begin(), runs.end(), later);
+        Run& run = runs.back();
+
+        do
+        {
+            triangles.push_back({ &run.bins->triangles, run.current->triangle, run.bins->blends[run.current->triangle] });
+            ++run.current;
+        }
+        while (run.current != run.end && (runs.size() == 1 || run.current->sequence < runs.front().current->sequence));
+
+        if (run.current == run.end)
+            runs.pop_back();
+        else
+            push_heap(runs.begin(), runs.end(), later);
+    }
+}
+
+void TileBinner::Rasterize(JobSystem& jobs, TGAImage& image, ClearMetadata* clearMetadata) const
+{
+    jobs.ParallelFor(0, GetTileCount(), 1, [&](size_t begin, size_t end)
+    {
+        vector<TileTriangle> triangles;
+        TileBuffer tileBuffer(tileSize, tileSize);
+
+        for (size_t tile = begin; tile < end; ++tile)
+        {
+            triangles.clear();
+            GatherTile((int)tile, triangles);
+
+            // Untouched tiles are not loaded at all
+            if (triangles.empty())
+                continue;
+
+            PROFILE_SCOPE("raster tile");
+
+            ScissorRect rect;
+            rect.minX = (int)(tile % tilesX) * tileSize;
+            rect.minY = (int)(tile / tilesX) * tileSize;
+            rect.maxX = min(rect.minX + tileSize, width) - 1;
+            rect.maxY = min(rect.minY + tileSize, height) - 1;
+
+            // Tiles own their pixels, so the threads never write the same memory
+            if (clearMetadata && clearMetadata->IsCleared((int)tile))
+                tileBuffer.Fill(rect, clearMetadata->GetClearColor());
+            else
+                tileBuffer.Load(image, rect);
+
+            {
+                SmallTriangleBatch smallTriangles(tileBuffer);
+
+                for (const TileTriangle& tileTriangle : triangles)
+                {
+                    const TriangleBatch& batch = *tileTriangle.triangles;
+                    const size_t index = tileTriangle.index;
+
+                    const vec4f v0 = batch.GetVertex(index, 0);
+                    const vec4f v1 = batch.GetVertex(index, 1);
+                    const vec4f v2 = batch.GetVertex(index, 2);
+
+                    if (IsSmallTriangle(v0, v1, v2))
+                    {
+                        smallTriangles.Add(v0, v1, v2, batch.GetColor(index, 0), batch.GetColor(index, 1), batch.GetColor(index, 2), tileTriangle.blend);
+                    }
+                    else
+                    {
+                        smallTriangles.Flush();
+                        DrawTriangleBC(tileBuffer, v0, v1, v2, batch.GetColor(index, 0), batch.GetColor(index, 1), batch.GetColor(index, 2), tileTriangle.blend);
+                    }
+                }
+            }
+
+            tileBuffer.Store(image);
+
+            if (clearMetadata)
+                clearMetadata->MarkWritten((int)tile);
+        }
+    });
+}
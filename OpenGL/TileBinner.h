@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Triangle.h"
+#include "TriangleBatch.h"
+#include "JobSystem.h"
+#include "tgaimage.h"
+#include "Blend.h"
+#include "ClearMetadata.h"
+
+/*
+	Sort-middle binning of raster space triangles.
+
+	Geometry workers clip their own ranges of triangles and add the results to
+	per thread, per tile bins, tagging each one with a sequence number built from
+	its input triangle index. A thread only appends increasing sequence numbers
+	within a range, so each bin is a run per range at most and a tile gets its
+	triangles back in submission order with a heap merge of those runs, no sort
+	needed. Ranges stolen from the end of a ParallelFor come in descending order
+	and make as many runs, the merge stays O(entries * log runs).
+
+	Each tile is drawn into a tile buffer loaded from the image and written back
+	once, so blended triangles read and write memory in cache.
+*/
+class TileBinner
+{
+public:
+	// Binned triangle with the blending of its draw
+	struct TileTriangle
+	{
+		const TriangleBatch* triangles;
+		uint32_t index;
+		BlendState blend;
+	};
+
+	// Sequence number of the subTriangle'th triangle clipped out of input triangle index
+	static uint64_t MakeSequence(size_t index, int subTriangle)
+	{
+		return ((uint64_t)index << 8) | (uint64_t)subTriangle;
+	}
+
+	TileBinner(int width, int height, int tileSize);
+
+	// Empties the bins for a new frame with threadCount binning threads, keeps the memory
+	void Reset(int threadCount);
+
+	// Adds raster space triangles to the bins of the tiles they can cover a sample of, called by thread. The ids are
+	// input triangle indices from firstTriangle, with the pieces of a clipped triangle next to each other
+	void Bin(int thread, const TriangleBatch& triangles, size_t firstTriangle, const BlendState& blend = BlendState());
+
+	// Triangles overlapping tile in sequence order
+	void GatherTile(int tile, std::vector<TileTriangle>& triangles) const;
+
+	// Draws every tile in parallel. With clear metadata made with the tile size of the binner, the tiles still
+	// cleared start from the clear color instead of the image and are marked written, the others are left cleared
+	void Rasterize(JobSystem& jobs, TGAImage& image, ClearMetadata* clearMetadata = nullptr) const;
+
+	int GetWidth() const
+	{
+		return width;
+	}
+
+	int GetHeight() const
+	{
+		return height;
+	}
+
+	int GetTileCount() const
+	{
+		return tilesX * tilesY;
+	}
+
+	size_t GetTriangleCount() const;
+
+private:
+	struct BinEntry
+	{
+		uint64_t sequence;
+		uint32_t triangle;	// Index in the triangles of the thread
+	};
+
+	struct ThreadBins
+	{
+		TriangleBatch triangles;
+		std::vector<BlendState> blends;		// Blending of each triangle
+		std::vector<std::vector<BinEntry>> tiles;
+	};
+
+	int width, height;
+	int tileSize;
+	int tilesX, tilesY;
+
+	std::vector<ThreadBins> threads;
+};
@@ -0,0 +1,203 @@
+#include "TriangleBatch.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace
+{
+    // Capacities are a multiple of this many triangles so every float array ends on the alignment
+    const size_t CAPACITY_GRANULE = TriangleBatch::ALIGNMENT / sizeof(float);
+
+    size_t RoundCapacity(size_t capacity)
+    {
+        return (capacity + CAPACITY_GRANULE - 1) / CAPACITY_GRANULE * CAPACITY_GRANULE;
+    }
+}
+
+TriangleBatch::TriangleBatch()
+    : ids(nullptr), count(0), capacity(0), memory(nullptr)
+{
+    std::fill(streams, streams + STREAM_COUNT, nullptr);
+}
+
+TriangleBatch::TriangleBatch(size_t capacity)
+    : TriangleBatch()
+{
+    Reserve(capacity);
+}
+
+TriangleBatch::~TriangleBatch()
+{
+    if (memory)
+        ::operator delete(memory, std::align_val_t(ALIGNMENT));
+}
+
+TriangleBatch::TriangleBatch(const TriangleBatch& other)
+    : TriangleBatch(other.count)
+{
+    Append(other);
+}
+
+TriangleBatch::TriangleBatch(TriangleBatch&& other) noexcept
+    : TriangleBatch()
+{
+    std::swap(streams, other.streams);
+    std::swap(ids, other.ids);
+    std::swap(count, other.count);
+    std::swap(capacity, other.capacity);
+    std::swap(memory, other.memory);
+}
+
+TriangleBatch& TriangleBatch::operator = (TriangleBatch other) noexcept
+{
+    std::swap(streams, other.streams);
+    std::swap(ids, other.ids);
+    std::swap(count, other.count);
+    std::swap(capacity, other.capacity);
+    std::swap(memory, other.memory);
+
+    return *this;
+}
+
+void TriangleBatch::Reserve(size_t newCapacity)
+{
+    if (newCapacity <= capacity)
+        return;
+
+    newCapacity = RoundCapacity(std::max(newCapacity, capacity * 2));
+
+    // Every float array followed by the ids, each newCapacity long
+    void* newMemory = ::operator new((STREAM_COUNT * sizeof(float) + sizeof(uint32_t)) * newCapacity, std::align_val_t(ALIGNMENT));
+
+    float* base = static_cast<float*>(newMemory);
+    for (int stream = 0; stream < STREAM_COUNT; ++stream)
+    {
+        float* newStream = base + stream * newCapacity;
+        if (count > 0)
+            memcpy(newStream, streams[stream], count * sizeof(float));
+
+        streams[stream] = newStream;
+    }
+
+    uint32_t* newIds = reinterpret_cast<uint32_t*>(base + STREAM_COUNT * newCapacity);
+    if (count > 0)
+        memcpy(newIds, ids, count * sizeof(uint32_t));
+
+    ids = newIds;
+
+    if (memory)
+        ::operator delete(memory, std::align_val_t(ALIGNMENT));
+
+    memory = newMemory;
+    capacity = newCapacity;
+}
+
+void TriangleBatch::Resize(size_t newCount)
+{
+    Reserve(newCount);
+    count = newCount;
+}
+
+void TriangleBatch::Add(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, uint32_t id)
+{
+    if (count == capacity)
+        Reserve(count + 1);
+
+    const size_t index = count++;
+
+    SetVertex(index, 0, v0);
+    SetVertex(index, 1, v1);
+    SetVertex(index, 2, v2);
+
+    SetColor(index, 0, c0);
+    SetColor(index, 1, c1);
+    SetColor(index, 2, c2);
+
+    ids[index] = id;
+}
+
+void TriangleBatch::Add(const TriangleBatch& other, size_t index)
+{
+    if (count == capacity)
+        Reserve(count + 1);
+
+    for (int stream = 0; stream < STREAM_COUNT; ++stream)
+        streams[stream][count] = other.streams[stream][index];
+
+    ids[count] = other.ids[index];
+    ++count;
+}
+
+void TriangleBatch::Append(const TriangleBatch& other, size_t begin, size_t end)
+{
+    if (begin >= end)
+        return;
+
+    const size_t added = end - begin;
+    if (count + added > capacity)
+        Reserve(count + added);
+
+    // A memcpy call per array costs more than copying a few floats
+    if (added < LANES)
+    {
+        for (int stream = 0; stream < STREAM_COUNT; ++stream)
+        {
+            for (size_t i = 0; i < added; ++i)
+                streams[stream][count + i] = other.streams[stream][begin + i];
+        }
+
+        for (size_t i = 0; i < added; ++i)
+            ids[count + i] = other.ids[begin + i];
+    }
+    else
+    {
+        for (int stream = 0; stream < STREAM_COUNT; ++stream)
+            memcpy(streams[stream] + count, other.streams[stream] + begin, added * sizeof(float));
+
+        memcpy(ids + count, other.ids + begin, added * sizeof(uint32_t));
+    }
+
+    count += added;
+}
+
+size_t TriangleBatch::Compact(const uint8_t* keep)
+{
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!keep[i])
+            continue;
+
+        if (kept != i)
+        {
+            for (int stream = 0; stream < STREAM_COUNT; ++stream)
+                streams[stream][kept] = streams[stream][i];
+
+            ids[kept] = ids[i];
+        }
+
+        ++kept;
+    }
+
+    const size_t removed = count - kept;
+    count = kept;
+
+    return removed;
+}
+
+void TriangleBatch::SetVertex(size_t index, int slot, const vec4f& vertex)
+{
+    Get(X, slot)[index] = vertex.x;
+    Get(Y, slot)[index] = vertex.y;
+    Get(Z, slot)[index] = vertex.z;
+    Get(W, slot)[index] = vertex.w;
+}
+
+void TriangleBatch::SetColor(size_t index, int slot, const vec3f& color)
+{
+    Get(R, slot)[index] = color.x;
+    Get(G, slot)[index] = color.y;
+    Get(B, slot)[index] = color.z;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Vector.h"
+#include "Triangle.h"
+
+/*
+	Triangles stored as a structure of arrays, one array per component of each vertex slot.
+
+	The stages of the pipeline walk the arrays LANES triangles at a time with plain loops over the lanes,
+	which the compiler turns into vector code, instead of loading whole Triangle objects one by one.
+	Every array starts on a 64 byte boundary and is padded to a multiple of LANES. The padding is never
+	initialized, so the loops stop at Size. Clear keeps the memory, growing doubles the capacity.
+
+	Each triangle also carries an id, the index of the input triangle it was made from. Clipping copies
+	it to every piece so later stages can keep the submission order.
+*/
+class TriangleBatch
+{
+public:
+	// Triangles processed together by the batch stages
+	static const size_t LANES = 8;
+
+	// Alignment of every array in bytes
+	static const size_t ALIGNMENT = 64;
+
+	enum Component
+	{
+		X = 0, Y, Z, W,
+		R, G, B,
+		COMPONENT_COUNT
+	};
+
+	TriangleBatch();
+	explicit TriangleBatch(size_t capacity);
+	~TriangleBatch();
+
+	TriangleBatch(const TriangleBatch& other);
+	TriangleBatch(TriangleBatch&& other) noexcept;
+	TriangleBatch& operator = (TriangleBatch other) noexcept;
+
+	// Grows the arrays to hold at least capacity triangles, the triangles already in are kept
+	void Reserve(size_t capacity);
+
+	// Sets the number of triangles, the new ones are left uninitialized
+	void Resize(size_t count);
+
+	// O(1), the memory is kept for the next frame
+	void Clear()
+	{
+		count = 0;
+	}
+
+	size_t Size() const
+	{
+		return count;
+	}
+
+	size_t Capacity() const
+	{
+		return capacity;
+	}
+
+	bool Empty() const
+	{
+		return count == 0;
+	}
+
+	void Add(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2, uint32_t id = 0);
+
+	void Add(const Triangle& triangle, uint32_t id = 0)
+	{
+		Add(triangle.vertices[0], triangle.vertices[1], triangle.vertices[2], triangle.colors[0], triangle.colors[1], triangle.colors[2], id);
+	}
+
+	// Copies triangle index of other to the end
+	void Add(const TriangleBatch& other, size_t index);
+
+	// Appends every triangle of other
+	void Append(const TriangleBatch& other)
+	{
+		Append(other, 0, other.count);
+	}
+
+	// Appends triangles begin to end of other
+	void Append(const TriangleBatch& other, size_t begin, size_t end);
+
+	// Keeps the triangles whose keep flag is set, in order. Returns the number removed
+	size_t Compact(const uint8_t* keep);
+
+	// Array of component for vertex slot 0 to 2
+	float* Get(Component component, int slot)
+	{
+		return streams[component * 3 + slot];
+	}
+
+	const float* Get(Component component, int slot) const
+	{
+		return streams[component * 3 + slot];
+	}
+
+	uint32_t* GetIds()
+	{
+		return ids;
+	}
+
+	const uint32_t* GetIds() const
+	{
+		return ids;
+	}
+
+	vec4f GetVertex(size_t index, int slot) const
+	{
+		return vec4f(Get(X, slot)[index], Get(Y, slot)[index], Get(Z, slot)[index], Get(W, slot)[index]);
+	}
+
+	vec3f GetColor(size_t index, int slot) const
+	{
+		return vec3f(Get(R, slot)[index], Get(G, slot)[index], Get(B, slot)[index]);
+	}
+
+	void SetVertex(size_t index, int slot, const vec4f& vertex);
+
+	void SetColor(size_t index, int slot, const vec3f& color);
+
+	// Triangle index as an object, for the stages still working on one triangle at a time
+	Triangle GetTriangle(size_t index) const
+	{
+		return Triangle(GetVertex(index, 0), GetVertex(index, 1), GetVertex(index, 2), GetColor(index, 0), GetColor(index, 1), GetColor(index, 2));
+	}
+
+private:
+	static const int STREAM_COUNT = COMPONENT_COUNT * 3;
+
+	float* streams[STREAM_COUNT];
+	uint32_t* ids;
+
+	size_t count;
+	size_t capacity;
+	void* memory;
+};
@@ -0,0 +1,63 @@
+#include "Varyings.h"
+#include "Rasterizer.h"
+
+bool SetupVaryingPlanes(VaryingPlanes& planes, const vec4f& v0, const vec4f& v1, const vec4f& v2,
+    const float* attributes0, const float* attributes1, const float* attributes2, int count)
+{
+    count = count < MAX_VARYINGS ? count : MAX_VARYINGS;
+    planes.count = count;
+    planes.originX = v0.x;
+    planes.originY = v0.y;
+
+    // Edge vectors from the first vertex
+    const float dx1 = v1.x - v0.x;
+    const float dy1 = v1.y - v0.y;
+    const float dx2 = v2.x - v0.x;
+    const float dy2 = v2.y - v0.y;
+
+    const float determinant = dx1 * dy2 - dx2 * dy1;
+
+    for (int k = 0; k < MAX_VARYINGS; ++k)
+    {
+        planes.a[k] = 0;
+        planes.b[k] = 0;
+        planes.c[k] = 0;
+    }
+
+    planes.aW = 0;
+    planes.bW = 0;
+    planes.cW = 1;
+
+    if (determinant == 0)
+        return false;
+
+    const float invDeterminant = 1 / determinant;
+
+#ifdef PERSPECTIVE_DIVIDE
+    const float q0 = 1 / v0.w;
+    const float q1 = 1 / v1.w;
+    const float q2 = 1 / v2.w;
+#else
+    const float q0 = 1;
+    const float q1 = 1;
+    const float q2 = 1;
+#endif // PERSPECTIVE_DIVIDE
+
+    // Gradient of a value given at the three vertices, solved from the two edges
+    auto SetPlane = [&](float p0, float p1, float p2, float& a, float& b, float& c)
+    {
+        const float d1 = p1 - p0;
+        const float d2 = p2 - p0;
+
+        a = (d1 * dy2 - d2 * dy1) * invDeterminant;
+        b = (d2 * dx1 - d1 * dx2) * invDeterminant;
+        c = p0;
+    };
+
+    SetPlane(q0, q1, q2, planes.aW, planes.bW, planes.cW);
+
+    for (int k = 0; k < count; ++k)
+        SetPlane(attributes0[k] * q0, attributes1[k] * q1, attributes2[k] * q2, planes.a[k], planes.b[k], planes.c[k]);
+
+    return true;
+}
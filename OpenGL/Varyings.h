@@ -0,0 +1,49 @@
+#pragma once
+#include "Vector.h"
+
+// Most float attributes a triangle can carry
+const int MAX_VARYINGS = 16;
+
+/*
+	Screen space plane equations of the attributes of a triangle.
+
+	With PERSPECTIVE_DIVIDE every attribute is divided by w at the vertices, those values and 1/w are linear
+	in screen space, so attribute k at sample (x, y) is
+
+		(a[k] * dx + b[k] * dy + c[k]) / (aW * dx + bW * dy + cW)		dx = x - originX, dy = y - originY
+
+	One reciprocal per sample and one multiply-add per attribute once the row terms b * dy + c are known, the
+	span kernel hoists them out of the row.
+	Without it the attributes are interpolated affinely and the w plane is the constant 1.
+	The planes are relative to the first vertex so the constants stay small next to the pixel coordinates.
+*/
+struct VaryingPlanes
+{
+	alignas(64) float a[MAX_VARYINGS];
+	alignas(64) float b[MAX_VARYINGS];
+	alignas(64) float c[MAX_VARYINGS];
+
+	float aW, bW, cW;
+	float originX, originY;
+	int count;
+};
+
+// Sets up count attributes given per vertex, returns false for a triangle without area
+bool SetupVaryingPlanes(VaryingPlanes& planes, const vec4f& v0, const vec4f& v1, const vec4f& v2,
+	const float* attributes0, const float* attributes1, const float* attributes2, int count);
+
+// Perspective correct value of every attribute at (x, y)
+inline void InterpolateVaryings(const VaryingPlanes& planes, float x, float y, float* out)
+{
+	const float dx = x - planes.originX;
+	const float dy = y - planes.originY;
+	const float w = 1 / (planes.aW * dx + (planes.bW * dy + planes.cW));
+
+	// Whole fixed size rows so the loop vectorizes across attributes, the unused ones are zero planes
+	alignas(64) float values[MAX_VARYINGS];
+	for (int k = 0; k < MAX_VARYINGS; ++k)
+		values[k] = (planes.a[k] * dx + (planes.b[k] * dy + planes.c[k])) * w;
+
+	for (int k = 0; k < planes.count; ++k)
+		out[k] = values[k];
+}
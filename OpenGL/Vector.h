@@ -10,4 +10,69 @@ typedef vec3<int> vec3i;
 typedef vec3<float> vec3f;
 
 typedef vec4<int> vec4i;
-typedef vec4<float> vec4f;
\ No newline at end of file
+typedef vec4<float> vec4f;
+
+/*
+	Fused forms of the interpolation patterns, one pass over the components with no vector temporaries.
+
+	Each step is a plain a * b + c, never std::fma, so these inline functions compile the same in every
+	translation unit, the kernel variants built with -mfma included, and they compute exactly what the
+	operator expressions in the comments do.
+*/
+inline float MultiplyAdd(float a, float b, float c)
+{
+	return a * b + c;
+}
+
+// a + (b - a) * t
+inline float Lerp(float a, float b, float t)
+{
+	return MultiplyAdd(b - a, t, a);
+}
+
+// a * wa + b * wb + c * wc
+inline float WeightedSum3(float a, float b, float c, float wa, float wb, float wc)
+{
+	return MultiplyAdd(c, wc, MultiplyAdd(b, wb, a * wa));
+}
+
+template <class Type>
+inline vec2<Type> Lerp(const vec2<Type>& a, const vec2<Type>& b, float t)
+{
+	return vec2<Type>(Lerp(a.x, b.x, t), Lerp(a.y, b.y, t));
+}
+
+template <class Type>
+inline vec3<Type> Lerp(const vec3<Type>& a, const vec3<Type>& b, float t)
+{
+	return vec3<Type>(Lerp(a.x, b.x, t), Lerp(a.y, b.y, t), Lerp(a.z, b.z, t));
+}
+
+template <class Type>
+inline vec4<Type> Lerp(const vec4<Type>& a, const vec4<Type>& b, float t)
+{
+	return vec4<Type>(Lerp(a.x, b.x, t), Lerp(a.y, b.y, t), Lerp(a.z, b.z, t), Lerp(a.w, b.w, t));
+}
+
+template <class Type>
+inline vec2<Type> WeightedSum3(const vec2<Type>& a, const vec2<Type>& b, const vec2<Type>& c, float wa, float wb, float wc)
+{
+	return vec2<Type>(WeightedSum3(a.x, b.x, c.x, wa, wb, wc), WeightedSum3(a.y, b.y, c.y, wa, wb, wc));
+}
+
+template <class Type>
+inline vec3<Type> WeightedSum3(const vec3<Type>& a, const vec3<Type>& b, const vec3<Type>& c, float wa, float wb, float wc)
+{
+	return vec3<Type>(WeightedSum3(a.x, b.x, c.x, wa, wb, wc),
+		WeightedSum3(a.y, b.y, c.y, wa, wb, wc),
+		WeightedSum3(a.z, b.z, c.z, wa, wb, wc));
+}
+
+template <class Type>
+inline vec4<Type> WeightedSum3(const vec4<Type>& a, const vec4<Type>& b, const vec4<Type>& c, float wa, float wb, float wc)
+{
+	return vec4<Type>(WeightedSum3(a.x, b.x, c.x, wa, wb, wc),
+		WeightedSum3(a.y, b.y, c.y, wa, wb, wc),
+		WeightedSum3(a.z, b.z, c.z, wa, wb, wc),
+		WeightedSum3(a.w, b.w, c.w, wa, wb, wc));
+}
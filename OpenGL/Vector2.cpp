@@ -1,4 +0,0 @@
-#include "Vector.h"
-
-template<> const vec2f vec2f::ZERO(0.0f, 0.0f);
-template<> const vec2i vec2i::ZERO(0, 0);
\ No newline at end of file
@@ -1,126 +1,113 @@
 #pragma once
 #include <iostream>
+#include <cmath>
+#include <type_traits>
 
 template <class Type>
 class vec2
 {
 public:
-	Type magnitude;
 	Type x, y;
 
 public:
-	vec2() :
-		x(0), y(0), magnitude(-1)
+	constexpr vec2() :
+		x(0), y(0)
 	{}
 
-	vec2(Type _x, Type _y)
+	constexpr vec2(Type _x, Type _y)
 		: x(_x), y(_y)
-	{
-		Magnitude();
-	}
-
-	vec2(const vec2& other)
-	{
-		x = other.x;
-		y = other.y;
-		magnitude = other.magnitude;
-	}
+	{}
 
-	vec2 operator + (const vec2& other) const
+	constexpr vec2 operator + (const vec2& other) const
 	{
 		return vec2(x + other.x, y + other.y);
 	}
 
-	vec2 operator - (const vec2& other) const
+	constexpr vec2 operator - (const vec2& other) const
 	{
 		return vec2(x - other.x, y - other.y);
 	}
 
-	vec2 operator * (const float scalar) const
+	constexpr vec2 operator * (const float scalar) const
 	{
 		return vec2(x * scalar, y * scalar);
 	}
 
-	vec2 operator / (const float scalar) const
+	constexpr vec2 operator / (const float scalar) const
 	{
-		return this * (1 / scalar);
+		return *this * (1 / scalar);
 	}
 
-	void operator += (const vec2& other)
+	constexpr void operator += (const vec2& other)
 	{
 		x = x + other.x;
 		y = y + other.y;
 	}
 
-	void operator -= (const vec2& other)
+	constexpr void operator -= (const vec2& other)
 	{
 		x = x - other.x;
 		y = y - other.y;
 	}
 
-	void operator *= (const float scalar)
+	constexpr void operator *= (const float scalar)
 	{
 		x = x * scalar;
 		y = y * scalar;
 	}
 
-	void operator /= (const float scalar)
+	constexpr void operator /= (const float scalar)
 	{
 		float invS = 1 / scalar;
 		x = x * invS;
 		y = y * invS;
 	}
 
-	bool operator == (const vec2& other)
+	constexpr bool operator == (const vec2& other) const
 	{
 		return (x == other.x && y == other.y);
 	}
 
-	bool operator < (const vec2& other)
+	constexpr bool operator < (const vec2& other) const
 	{
 		return (x < other.x && y < other.y);
 	}
 
-	bool operator > (const vec2& other)
+	constexpr bool operator > (const vec2& other) const
 	{
-		return (x > other.x&& y > other.y);
+		return (x > other.x && y > other.y);
 	}
 
-	bool operator <= (const vec2& other)
+	constexpr bool operator <= (const vec2& other) const
 	{
-		return (x <= other.x&& y <= other.y);
+		return (x <= other.x && y <= other.y);
 	}
 
-	bool operator >= (const vec2& other)
+	constexpr bool operator >= (const vec2& other) const
 	{
 		return (x >= other.x && y >= other.y);
 	}
 
-	float Dot(const vec2& other)
+	constexpr float Dot(const vec2& other) const
 	{
 		return (x * other.x + y * other.y);
 	}
 
 	vec2 Normalized() const
 	{
-		if (magnitude == -1)
-			Magnitude();
-
-		if(magnitude == 0)
-			return 0;
-
-		return this / magnitude;
+		vec2 result = *this;
+		result.Normalize();
+		return result;
 	}
 
 	void Normalize()
 	{
-		if (magnitude == -1)
-			Magnitude();
+		Type magnitude = Magnitude();
 
 		if (magnitude == 0)
 			return;
 
-		this /= magnitude;
+		*this /= magnitude;
 	}
 
 	/*
@@ -134,11 +121,11 @@ public:
 	the e0 and e1 are the same
 	*/
 
-	static float EdgeFunction(const vec2& e0, const vec2& e1)
+	static constexpr float EdgeFunction(const vec2& e0, const vec2& e1)
 	{
 		return (e0.x * e1.y - e0.y * e1.x);
 	}
-	
+
 
 	/*
 		If the return value
@@ -147,7 +134,7 @@ public:
 		0 P is on edge a, b
 	*/
 
-	static float EdgeFunction(const vec2& a, const vec2& b, const vec2& p)
+	static constexpr float EdgeFunction(const vec2& a, const vec2& b, const vec2& p)
 	{
 		vec2 e0 = p - a;
 		vec2 e1 = b - a;
@@ -161,10 +148,21 @@ public:
 		return os;
 	}
 
-	void Magnitude()
+	// Length, sqrt keeps it out of constant expressions
+	Type Magnitude() const
+	{
+		return (Type)sqrt(x * x + y * y);
+	}
+
+	constexpr Type SqrMagnitude() const
 	{
-		magnitude = (Type)sqrt(x * x + y * y);
+		return x * x + y * y;
 	}
 
 	static const vec2 ZERO;
-};
\ No newline at end of file
+};
+
+template <class Type>
+constexpr vec2<Type> vec2<Type>::ZERO = vec2<Type>(0, 0);
+
+static_assert(std::is_trivially_copyable<vec2<float>>::value, "vec2 is copied as plain memory");
@@ -1,4 +0,0 @@
-#include "Vector.h"
-
-template<> const vec3f vec3f::ZERO(0.0f, 0.0f, 0.0f);
-template<> const vec3i vec3i::ZERO(0, 0, 0);
\ No newline at end of file
@@ -1,81 +1,72 @@
 #pragma once
 #include <iostream>
+#include <cmath>
+#include <type_traits>
 
 template <class Type>
 class vec3
 {
 public:
-	Type magnitude;
 	Type x, y, z;
 
 public:
-	vec3() :
-		x(0), y(0), z(0), magnitude(-1)
+	constexpr vec3() :
+		x(0), y(0), z(0)
 	{
-		
-	}
 
-	vec3(Type _x, Type _y, Type _z)
-		: x(_x), y(_y), z(_z)
-	{
-		Magnitude();
 	}
 
-	vec3(const vec3& other)
-	{
-		x = other.x;
-		y = other.y;
-		z = other.z;
-		magnitude = other.magnitude;
-	}
+	constexpr vec3(Type _x, Type _y, Type _z)
+		: x(_x), y(_y), z(_z)
+	{}
 
 	// Adding 2 vectors
-	vec3 operator + (const vec3& other) const
+	constexpr vec3 operator + (const vec3& other) const
 	{
 		return vec3(x + other.x, y + other.y, z + other.z);
 	}
 
 	//Subtracting 2 vectors
-	vec3 operator - (const vec3& other) const
+	constexpr vec3 operator - (const vec3& other) const
 	{
 		return vec3(x - other.x, y - other.y, z - other.z);
 	}
 
 	//Scalar multiplication of a vector
-	vec3 operator * (const float scalar) const
+	constexpr vec3 operator * (const float scalar) const
 	{
 		return vec3(x * scalar, y * scalar, z * scalar);
 	}
 
 	//Scalar division
-	vec3 operator / (const float scalar) const
+	constexpr vec3 operator / (const float scalar) const
 	{
 		float invScalar = 1 / scalar;
 		return *this * invScalar;
 	}
 
-	void operator += (const vec3& other)
+	constexpr void operator += (const vec3& other)
 	{
 		x = x + other.x;
 		y = y + other.y;
 		z = z + other.z;
 	}
 
-	void operator -= (const vec3& other)
+	constexpr void operator -= (const vec3& other)
 	{
 		x = x - other.x;
 		y = y - other.y;
 		z = z - other.z;
 	}
 
-	void operator *= (const float scalar)
+	constexpr void operator *= (const float scalar)
 	{
 		x = x * scalar;
 		y = y * scalar;
 		z = z * scalar;
 	}
 
-	void operator /= (const float scalar)
+	constexpr void operator /= (const float scalar)
 	{
 		float invS = 1 / scalar;
 		x = x * invS;
@@ -84,83 +75,82 @@ public:
 	}
 
 	// Equals
-	bool operator ==(const vec3& other) const
+	constexpr bool operator ==(const vec3& other) const
 	{
 		return (x == other.x && y == other.y && z == other.z);
 	}
 
 	//Less than
-	bool operator < (const vec3& other) const
+	constexpr bool operator < (const vec3& other) const
 	{
 		return (x < other.x && y < other.y && z < other.z);
 	}
 
 	//Greater than
-	bool operator >(const vec3 other) const
+	constexpr bool operator >(const vec3& other) const
 	{
-		return (other < this);
+		return (other < *this);
 	}
 
-	bool operator <= (const vec3& other) const
+	constexpr bool operator <= (const vec3& other) const
 	{
 		return (x <= other.x && y <= other.y && z <= other.z);
 	}
 
 	//Greater than
-	bool operator >=(const vec3 other) const
+	constexpr bool operator >=(const vec3& other) const
 	{
-		return (other <= this);
+		return (other <= *this);
 	}
 
 	//Dot
-	float Dot(const vec3& other)
+	constexpr float Dot(const vec3& other) const
 	{
 		return (x * other.x + y * other.y + z * other.z);
 	}
 
-	//Length
-	void Magnitude()
+	//Length, sqrt keeps it out of constant expressions
+	Type Magnitude() const
 	{
-		magnitude = (Type)sqrt(x * x + y * y + z * z);
+		return (Type)sqrt(x * x + y * y + z * z);
 	}
 
-	//return a new Normalized vector to unit length
-	vec3 Normalized() const 
+	constexpr Type SqrMagnitude() const
 	{
-		if (magnitude == -1)
-			Magnitude();
-
-		if (magnitude == 0)
-			return ZERO;
+		return x * x + y * y + z * z;
+	}
 
-		return this / magnitude;
+	//return a new Normalized vector to unit length
+	vec3 Normalized() const
+	{
+		vec3 result = *this;
+		result.Normalize();
+		return result;
 	}
 
 	// Normalize the vector to unit length
 	void Normalize()
 	{
-		if (magnitude == -1)
-			Magnitude();
+		Type magnitude = Magnitude();
 
 		if (magnitude == 0)
 			return;
 
-		this /= magnitude;
+		*this /= magnitude;
 	}
 
 	// Accessor for x, y, z
-	Type operator [] (const int index) const
+	constexpr Type operator [] (const int index) const
 	{
 		if (index == 0)
 			return x;
 		if (index == 1)
 			return y;
-		if (index == 2)
-			return z;
+		return z;
 	}
 
 	// construct a vector 2 from x and y components
-	vec2<Type> GetXY() const
+	constexpr vec2<Type> GetXY() const
 	{
 		return vec2<Type>(x, y);
 	}
@@ -174,7 +164,7 @@ public:
 
 
 	// Static Dot
-	static float Dot(const vec3& v1, const vec3& v2)
+	static constexpr float Dot(const vec3& v1, const vec3& v2)
 	{
 		return (v1.x * v2.x + v1.y * v2.y + v1.z * v2.z);
 	}
@@ -182,18 +172,18 @@ public:
 	// Angle between 2 vectors
 	static float Angle(const vec3& from, const vec3& target)
 	{
-		return acos(Dot(from, target) / (from.magnitude * target.magnitude));
+		return acos(Dot(from, target) / (from.Magnitude() * target.Magnitude()));
 	}
 
 	//Static Cross product
-	static vec3 Cross(const vec3& v1, const vec3& v2)
+	static constexpr vec3 Cross(const vec3& v1, const vec3& v2)
 	{
 		vec3 result;
 		//	i	j	k
 		//	v1x	v1y	v1z
-		//	v2x	v2y	v2z	
+		//	v2x	v2y	v2z
 		result.x = v1.y * v2.z - v1.z * v2.y;
-		result.y = v1.x * v2.z - v2.x * v1.z;
+		result.y = v1.z * v2.x - v1.x * v2.z;
 		result.z = v1.x * v2.y - v1.y * v2.x;
 
 		return result;
@@ -202,8 +192,13 @@ public:
 	static float Distance(const vec3& v1, const vec3& v2)
 	{
 		vec3 v = v1 - v2;
-		return v.magnitude;
+		return v.Magnitude();
 	}
 
 	static const vec3 ZERO;
 };
+
+template <class Type>
+constexpr vec3<Type> vec3<Type>::ZERO = vec3<Type>(0, 0, 0);
+
+static_assert(std::is_trivially_copyable<vec3<float>>::value, "vec3 is copied as plain memory");
@@ -1,4 +0,0 @@
-#include "Vector.h"
-
-template<> const vec4f vec4f::ZERO(0.0f, 0.0f, 0.0f, 0.0f);
-template<> const vec4i vec4i::ZERO(0,0,0,0);
\ No newline at end of file
@@ -1,67 +1,52 @@
 #pragma once
+#include <cmath>
+#include <type_traits>
 
 template<class Type>
 class vec4
 {
 public:
 	Type x, y, z, w;
-	Type magnitude;
 
 public:
 
-	vec4() :
-		x(0), y(0), z(0), w(0), magnitude(-1)
+	constexpr vec4() :
+		x(0), y(0), z(0), w(0)
 	{}
 
-	vec4(Type _x, Type _y, Type _z, Type _w)
+	constexpr vec4(Type _x, Type _y, Type _z, Type _w)
 		: x(_x), y(_y), z(_z), w(_w)
-	{
-		Magnitude();
-	}
-
-	vec4(const vec3<Type>& vector3)
-	{
-		x = vector3.x;
-		y = vector3.y;
-		z = vector3.z;
-		w = 1;
-	}
-
-	vec4(const vec4& other)
-	{
-		x = other.x;
-		y = other.y;
-		z = other.z;
-		w = other.w;
+	{}
 
-		magnitude = other.magnitude;
-	}
+	constexpr vec4(const vec3<Type>& vector3)
+		: x(vector3.x), y(vector3.y), z(vector3.z), w(1)
+	{}
 
 	// Adding 2 vectors
-	vec4 operator + (const vec4& other) const
+	constexpr vec4 operator + (const vec4& other) const
 	{
 		return vec4(x + other.x, y + other.y, z + other.z, w + other.w);
 	}
 
 	//Subtracting 2 vectors
-	vec4 operator - (const vec4& other) const
+	constexpr vec4 operator - (const vec4& other) const
 	{
 		return vec4(x - other.x, y - other.y, z - other.z, w - other.w);
 	}
 
 	//Scalar multiplication of a vector
-	vec4 operator *(const float scalar) const
+	constexpr vec4 operator *(const float scalar) const
 	{
 		return vec4(x * scalar, y * scalar, z * scalar, w * scalar);
 	}
 
 	//Scalar division
-	vec4 operator /(const float scalar) const
+	constexpr vec4 operator /(const float scalar) const
 	{
-		return this * 1 / scalar;
+		return *this * (1 / scalar);
 	}
 
-	void operator += (const vec4& other)
+	constexpr void operator += (const vec4& other)
 	{
 		x = x + other.x;
 		y = y + other.y;
@@ -69,7 +54,7 @@ public:
 		w = w + other.w;
 	}
 
-	void operator -= (const vec4& other)
+	constexpr void operator -= (const vec4& other)
 	{
 		x = x - other.x;
 		y = y - other.y;
@@ -77,7 +62,7 @@ public:
 		w = w - other.w;
 	}
 
-	void operator *= (const float scalar)
+	constexpr void operator *= (const float scalar)
 	{
 		x = x * scalar;
 		y = y * scalar;
@@ -86,7 +71,7 @@ public:
 
 	}
 
-	void operator /= (const float scalar)
+	constexpr void operator /= (const float scalar)
 	{
 		float invS = 1 / scalar;
 		x = x * invS;
@@ -96,45 +81,51 @@ public:
 	}
 
 	// Equals
-	bool operator ==(const vec4& other)
+	constexpr bool operator ==(const vec4& other) const
 	{
 		return (x == other.x && y == other.y && z == other.z && w == other.w);
 	}
 
 	//Less than
-	bool operator < (const vec4& other)
+	constexpr bool operator < (const vec4& other) const
 	{
 		return (x < other.x&& y < other.y&& z < other.z&& w < other.w);
 	}
 
 	//Greater than
-	bool operator >(const vec4& other)
+	constexpr bool operator >(const vec4& other) const
 	{
-		return (other < this);
+		return (other < *this);
 	}
 
-	bool operator <= (const vec4& other)
+	constexpr bool operator <= (const vec4& other) const
 	{
 		return (x <= other.x && y <= other.y && z <= other.z && w <= other.w);
 	}
 
 	//Greater than
-	bool operator >=(const vec4& other)
+	constexpr bool operator >=(const vec4& other) const
 	{
-		return (other <= this);
+		return (other <= *this);
 	}
 
-	vec3<Type> GetVec3()
+	constexpr vec3<Type> GetVec3() const
 	{
 		return vec3<Type>(x, y, z);
 	}
 
-	void Magnitude()
+	// Length, sqrt keeps it out of constant expressions
+	Type Magnitude() const
 	{
-		magnitude = (Type)sqrt(x * x + y * y + z * z + w* w);
+		return (Type)sqrt(x * x + y * y + z * z + w* w);
 	}
 
-	float Dot(const vec4& other) const
+	constexpr Type SqrMagnitude() const
+	{
+		return x * x + y * y + z * z + w * w;
+	}
+
+	constexpr float Dot(const vec4& other) const
 	{
 		return (x * other.x + y * other.y + z * other.z + w * other.w);
 	}
@@ -142,36 +133,36 @@ public:
 	//return a new Normalized vector to unit length
 	vec4 Normalized() const
 	{
-		if (magnitude == -1)
-			Magnitude();
-
-		if (magnitude == 0)
-			return ZERO;
-
-		return this / magnitude;
+		vec4 result = *this;
+		result.Normalize();
+		return result;
 	}
 
 	// Normalize the vector to unit length
 	void Normalize()
 	{
-		if (magnitude == -1)
-			Magnitude();
+		Type magnitude = Magnitude();
 
 		if (magnitude == 0)
 			return;
 
-		this /= magnitude;
+		*this /= magnitude;
 	}
 
-	vec2<Type> GetXY() const
+	constexpr vec2<Type> GetXY() const
 	{
 		return vec2<Type>(x, y);
 	}
 
-	vec3<Type> GetXYZ() const
+	constexpr vec3<Type> GetXYZ() const
 	{
 		return vec3<Type>(x, y, z);
 	}
 
 	static const vec4 ZERO;
-};
\ No newline at end of file
+};
+
+template <class Type>
+constexpr vec4<Type> vec4<Type>::ZERO = vec4<Type>(0, 0, 0, 0);
+
+static_assert(std::is_trivially_copyable<vec4<float>>::value, "vec4 is copied as plain memory");
@@ -0,0 +1,127 @@
+#include "VisibilityBuffer.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace std;
+
+VisibilityBuffer::VisibilityBuffer(int width, int height)
+    : width(width), height(height), depthTest(false),
+    ids(width * height, INVALID_ID), depths(width * height, FLT_MAX)
+{
+}
+
+void VisibilityBuffer::Clear()
+{
+    fill(ids.begin(), ids.end(), INVALID_ID);
+    fill(depths.begin(), depths.end(), FLT_MAX);
+    triangles.clear();
+}
+
+uint32_t VisibilityBuffer::AddTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2)
+{
+    const uint32_t id = (uint32_t)triangles.size();
+    triangles.push_back({ v0, v1, v2, c0, c1, c2 });
+
+    const float area = vec2f::EdgeFunction(v0.GetXY(), v1.GetXY(), v2.GetXY());
+
+    if (area == 0)
+        return id;
+
+    // Same sample range as DrawTriangleBC, clamped to the buffer
+    int minX = max(0, (int)min(v0.x, min(v1.x, v2.x)));
+    int minY = max(0, (int)min(v0.y, min(v1.y, v2.y)));
+    float maxX = min((float)(width - 1), max(v0.x, max(v1.x, v2.x)));
+    float maxY = min((float)(height - 1), max(v0.y, max(v1.y, v2.y)));
+
+    float invArea = 1 / area;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            // The weights of EdgeWeights, without a setup
+            const float px = (float)x;
+            const float py = (float)y;
+            float u = (px - v1.x) * (v2.y - v1.y) - (py - v1.y) * (v2.x - v1.x);
+            float s = (px - v2.x) * (v0.y - v2.y) - (py - v2.y) * (v0.x - v2.x);
+            float t = (px - v0.x) * (v1.y - v0.y) - (py - v0.y) * (v1.x - v0.x);
+
+            if (u <= 0 && s <= 0 && t <= 0)
+            {
+                // z is already divided by w, so it is linear in screen space
+                float z = WeightedSum3(v0.z, v1.z, v2.z, u, s, t) * invArea;
+
+                const int pixel = x + y * width;
+
+                if (depthTest && z >= depths[pixel])
+                    continue;
+
+                ids[pixel] = id;
+                depths[pixel] = z;
+            }
+        }
+    }
+
+    return id;
+}
+
+void VisibilityBuffer::ShadeRows(TGAImage& image, int beginRow, int endRow) const
+{
+    for (int y = beginRow; y < endRow; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const uint32_t id = ids[x + y * width];
+
+            if (id == INVALID_ID)
+                continue;
+
+            const TriangleSetup& setup = setups[setupIndices[id]];
+
+            image.set(x, y, ShadeFragment(setup, (float)x, (float)y));
+        }
+    }
+}
+
+void VisibilityBuffer::Shade(TGAImage& image, JobSystem& jobs)
+{
+    const size_t SETUPS_PER_JOB = 256;
+
+    // Every pixel is written by exactly one job
+    const size_t ROWS_PER_JOB = 16;
+
+    // Triangles hidden everywhere are never set up. Neighbouring pixels mostly have the same triangle
+    setupIndices.assign(triangles.size(), INVALID_ID);
+    visibleTriangles.clear();
+
+    uint32_t previous = INVALID_ID;
+    for (uint32_t id : ids)
+    {
+        if (id == previous)
+            continue;
+
+        previous = id;
+
+        if (id != INVALID_ID && setupIndices[id] == INVALID_ID)
+        {
+            setupIndices[id] = (uint32_t)visibleTriangles.size();
+            visibleTriangles.push_back(id);
+        }
+    }
+
+    setups.resize(visibleTriangles.size());
+
+    jobs.ParallelFor(0, visibleTriangles.size(), SETUPS_PER_JOB, [&](size_t begin, size_t end)
+    {
+        for (size_t index = begin; index < end; ++index)
+        {
+            const RasterTriangle& triangle = triangles[visibleTriangles[index]];
+            setups[index] = SetupTriangle(triangle.v0, triangle.v1, triangle.v2, triangle.c0, triangle.c1, triangle.c2);
+        }
+    });
+
+    jobs.ParallelFor(0, height, ROWS_PER_JOB, [&](size_t beginRow, size_t endRow)
+    {
+        ShadeRows(image, (int)beginRow, (int)endRow);
+    });
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "tgaimage.h"
+#include "Rasterizer.h"
+#include "JobSystem.h"
+
+/*
+	Deferred shading through a visibility buffer.
+
+	The raster pass only stores the id of the triangle and its depth for every
+	pixel, and of the triangle its raster vertices and colors. The shading pass
+	then sets up the plane equations of the triangles that own a pixel, once
+	each, and shades each pixel exactly once, so neither cost grows with overdraw.
+*/
+class VisibilityBuffer
+{
+public:
+	static const uint32_t INVALID_ID = 0xFFFFFFFF;
+
+	VisibilityBuffer(int width, int height);
+
+	// Forget all triangles and mark every pixel as empty
+	void Clear();
+
+	// Rasterizes the triangle into the buffer and returns its id.
+	// Without depth test the last triangle wins like with DrawTriangleBC
+	uint32_t AddTriangle(const vec4f& v0, const vec4f& v1, const vec4f& v2, const vec3f& c0, const vec3f& c1, const vec3f& c2);
+
+	// Shades every covered pixel once into the image, the setups and bands of rows are done in parallel.
+	// Pixels without a triangle are left untouched
+	void Shade(TGAImage& image, JobSystem& jobs);
+
+	void SetDepthTest(bool enable)
+	{
+		depthTest = enable;
+	}
+
+	uint32_t GetTriangleId(int x, int y) const
+	{
+		return ids[x + y * width];
+	}
+
+	float GetDepth(int x, int y) const
+	{
+		return depths[x + y * width];
+	}
+
+	size_t GetTriangleCount() const
+	{
+		return triangles.size();
+	}
+
+private:
+	// What AddTriangle keeps of a triangle
+	struct RasterTriangle
+	{
+		vec4f v0, v1, v2;
+		vec3f c0, c1, c2;
+	};
+
+	void ShadeRows(TGAImage& image, int beginRow, int endRow) const;
+
+	int width, height;
+	bool depthTest;
+
+	std::vector<uint32_t> ids;
+	std::vector<float> depths;
+	std::vector<RasterTriangle> triangles;
+
+	// Filled by Shade, kept to reuse the memory
+	std::vector<uint32_t> setupIndices;		// Per triangle, its setup or INVALID_ID when it owns no pixel
+	std::vector<uint32_t> visibleTriangles;	// Triangle of every setup
+	std::vector<TriangleSetup> setups;
+};
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <cstring>
 #include "tgaimage.h"
+#include "Kernels.h"
 
 TGAImage::TGAImage() : data(), width(0), height(0), bytespp(0) {}
 TGAImage::TGAImage(const int w, const int h, const int bpp) : data(w*h*bpp, 0), width(w), height(h), bytespp(bpp) {}
@@ -168,40 +169,15 @@ bool TGAImage::write_tga_file(const std::string filename, const bool vflip, cons
 
 // TODO: it is not necessary to break a raw chunk for two equal pixels (for the matter of the resulting size)
 bool TGAImage::unload_rle_data(std::ofstream &out) const {
-    const std::uint8_t max_chunk_length = 128;
+    // encoded in memory by the kernel of the running CPU, then written at once
     size_t npixels = width*height;
-    size_t curpix = 0;
-    while (curpix<npixels) {
-        size_t chunkstart = curpix*bytespp;
-        size_t curbyte = curpix*bytespp;
-        std::uint8_t run_length = 1;
-        bool raw = true;
-        while (curpix+run_length<npixels && run_length<max_chunk_length) {
-            bool succ_eq = true;
-            for (int t=0; succ_eq && t<bytespp; t++)
-                succ_eq = (data[curbyte+t]==data[curbyte+t+bytespp]);
-            curbyte += bytespp;
-            if (1==run_length)
-                raw = !succ_eq;
-            if (raw && succ_eq) {
-                run_length--;
-                break;
-            }
-            if (!raw && !succ_eq)
-                break;
-            run_length++;
-        }
-        curpix += run_length;
-        out.put(raw?run_length-1:run_length+127);
-        if (!out.good()) {
-            std::cerr << "can't dump the tga file\n";
-            return false;
-        }
-        out.write(reinterpret_cast<const char *>(data.data()+chunkstart), (raw?run_length*bytespp:bytespp));
-        if (!out.good()) {
-            std::cerr << "can't dump the tga file\n";
-            return false;
-        }
+    std::vector<std::uint8_t> scratch(npixels*bytespp);
+    std::vector<std::uint8_t> encoded(npixels*(bytespp+1));
+    size_t size = GetKernels().EncodeRle(data.data(), npixels, bytespp, scratch.data(), encoded.data());
+    out.write(reinterpret_cast<const char *>(encoded.data()), size);
+    if (!out.good()) {
+        std::cerr << "can't dump the tga file\n";
+        return false;
     }
     return true;
 }
@@ -217,7 +193,7 @@ void TGAImage::set(int x, int y, const TGAColor &c) {
     memcpy(data.data()+(x+y*width)*bytespp, c.bgra, bytespp);
 }
 
-int TGAImage::get_bytespp() {
+int TGAImage::get_bytespp() const {
     return bytespp;
 }
 
@@ -260,6 +236,10 @@ std::uint8_t *TGAImage::buffer() {
     return data.data();
 }
 
+const std::uint8_t *TGAImage::buffer() const {
+    return data.data();
+}
+
 void TGAImage::clear() {
     data = std::vector<std::uint8_t>(width*height*bytespp, 0);
 }
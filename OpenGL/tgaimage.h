@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <algorithm>
 
 #pragma pack(push,1)
 struct TGA_Header {
@@ -68,8 +70,9 @@ public:
     void set(const int x, const int y, const TGAColor &c);
     int get_width() const;
     int get_height() const;
-    int get_bytespp();
+    int get_bytespp() const;
     std::uint8_t *buffer();
+    const std::uint8_t *buffer() const;
     void clear();
 };
 